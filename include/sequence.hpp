@@ -8,16 +8,122 @@
 #include <vector>
 #endif
 
+// POSIX file descriptor output
+#if SEQUENCE_ENABLE_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstdlib>
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#endif
+
+// Block evaluation of arithmetic pipelines is used by default when the compiler targets AVX2,
+// where the blocks are vectorized profitably. Define SEQUENCE_ENABLE_BLOCKS to 0 or 1 to override this.
+#ifndef SEQUENCE_ENABLE_BLOCKS
+#if defined(__AVX2__)
+#define SEQUENCE_ENABLE_BLOCKS 1
+#else
+#define SEQUENCE_ENABLE_BLOCKS 0
+#endif
+#endif
+
+// AVX2 search kernels and SSE4.2 CRC32C are selected at run time on x86 with GCC and Clang,
+// even if the compiler does not target them. They are compiled using target attributes and builtins,
+// so <immintrin.h> is only included when the compiler targets AVX2.
+// Define SEQUENCE_CPU_DISPATCH to 0 to only use them when the compiler targets them.
+// SEQUENCE_AVX2_DISPATCH is the former name of SEQUENCE_CPU_DISPATCH.
+#ifndef SEQUENCE_CPU_DISPATCH
+#ifdef SEQUENCE_AVX2_DISPATCH
+#define SEQUENCE_CPU_DISPATCH SEQUENCE_AVX2_DISPATCH
+#else
+#define SEQUENCE_CPU_DISPATCH 1
+#endif
+#endif
+#if SEQUENCE_CPU_DISPATCH && !((defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)))
+#undef SEQUENCE_CPU_DISPATCH
+#define SEQUENCE_CPU_DISPATCH 0
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #include <type_traits>
 #include <cstring>
 #include <iterator>
 #include <stdexcept>
 #include <array>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <mutex>
+#include <exception>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <algorithm>
+#include <tuple>
+#include <functional>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<ranges>)
+#include <ranges>
+#endif
+#endif
+
+// probe() stages measure pipelines if SEQUENCE_ENABLE_PROFILING is enabled, and do nothing otherwise
+#ifndef SEQUENCE_ENABLE_PROFILING
+#define SEQUENCE_ENABLE_PROFILING 0
+#endif
+
+#if SEQUENCE_ENABLE_PROFILING
+#include <chrono>
+#endif
+
+// sequences::concurrent_output is only available if SEQUENCE_ENABLE_CONCURRENT_OUTPUT is enabled
+#ifndef SEQUENCE_ENABLE_CONCURRENT_OUTPUT
+#define SEQUENCE_ENABLE_CONCURRENT_OUTPUT 0
+#endif
+
+// Threads are used by concurrent_output and by file_reader()
+#if SEQUENCE_ENABLE_CONCURRENT_OUTPUT || SEQUENCE_ENABLE_POSIX
+#include <thread>
+#include <condition_variable>
+#endif
+
+// Internal buffers are counted in sequences::allocation_counters if SEQUENCE_ENABLE_ALLOCATION_COUNTERS is enabled
+#ifndef SEQUENCE_ENABLE_ALLOCATION_COUNTERS
+#define SEQUENCE_ENABLE_ALLOCATION_COUNTERS 0
+#endif
+
+// Sequences can be evaluated in constant expressions from C++17, which has constexpr lambdas
+#ifndef SEQUENCE_CONSTEXPR
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201603L
+#define SEQUENCE_CONSTEXPR constexpr
+#else
+#define SEQUENCE_CONSTEXPR
+#endif
+#endif
 
 #include "sequence_fwd.hpp"
 #include "sequences/fwd.hpp"
 #include "sequences/helpers.hpp"
+#include "sequences/arena.hpp"
 #include "sequences/int_iterator.hpp"
+#include "sequences/simd.hpp"
+#if SEQUENCE_ENABLE_PROFILING
+#include "sequences/profiler.hpp"
+#endif
+#include "sequences/ranges.hpp"
 
 #include "sequences/base_sequence.hpp"
 #include "sequences/sequence.hpp"
@@ -26,6 +132,7 @@
 #include "sequences/empty_sequence.hpp"
 #include "sequences/singleton_sequence.hpp"
 #include "sequences/iterator_sequence.hpp"
+#include "sequences/range_sequence.hpp"
 #include "sequences/where_sequence.hpp"
 #include "sequences/select_sequence.hpp"
 #include "sequences/pointer_sequence.hpp"
@@ -36,10 +143,35 @@
 #include "sequences/take_while_sequence.hpp"
 #include "sequences/skip_until_sequence.hpp"
 #include "sequences/merge_sequence.hpp"
+#include "sequences/zip_sequence.hpp"
 #include "sequences/output_sequence.hpp"
 #include "sequences/generated_sequence.hpp"
 #include "sequences/repeat_sequence.hpp"
 #include "sequences/split_sequence.hpp"
+#include "sequences/chunked_buffer.hpp"
+#include "sequences/reverse_sequence.hpp"
+#include "sequences/cached_sequence.hpp"
+#include "sequences/serialization.hpp"
+#include "sequences/spill_sequence.hpp"
+#include "sequences/record_file.hpp"
+#include "sequences/select_many_sequence.hpp"
+#if SEQUENCE_ENABLE_CONCURRENT_OUTPUT
+#include "sequences/concurrent_output.hpp"
+#endif
+#include "sequences/merge_sorted_sequence.hpp"
+#include "sequences/set_sequence.hpp"
+#include "sequences/window_sequence.hpp"
+#include "sequences/chunk_sequence.hpp"
+#include "sequences/hash.hpp"
+#if SEQUENCE_ENABLE_PROFILING
+#include "sequences/probe_sequence.hpp"
+#endif
+#include "sequences/prefetch_sequence.hpp"
+
+#if SEQUENCE_ENABLE_POSIX
+#include "sequences/fd_output.hpp"
+#include "sequences/file_source.hpp"
+#endif
 
 // Constructs a sequence from a container
 template<typename Container, typename = typename Container::value_type>
@@ -57,14 +189,14 @@ sequences::iterator_sequence<typename Container::const_iterator> seq(Container &
 
 // Constructs a sequence from a fixed-length array
 template<typename T, int Size>
-pointer_sequence<T> seq(const T (&items)[Size])
+SEQUENCE_CONSTEXPR pointer_sequence<T> seq(const T (&items)[Size])
 {
     return {items, items+Size};
 }
 
 // Constructs a sequence from a list
 template<typename T, typename...Ts>
-sequences::stored_sequence<std::array<T,1+sizeof...(Ts)>> list(T t, Ts... ts)
+SEQUENCE_CONSTEXPR sequences::stored_sequence<std::array<T,1+sizeof...(Ts)>> list(T t, Ts... ts)
 {
     return {std::array<T,1+sizeof...(Ts)>({t, ts...})};
 }
@@ -81,10 +213,29 @@ sequences::empty_sequence<T> seq() { return {}; }
 template<typename T>
 sequences::empty_sequence<T> list() { return {}; }
 
-// Constructs an integer range sequence
-inline sequences::iterator_sequence<sequences::int_iterator> seq(int a, int b)
+// Constructs an integer range sequence from a to b inclusive.
+// The integers have the promoted common type of a and b, which is signed if either is signed.
+template<typename A, typename B, typename = typename std::enable_if<std::is_integral<A>::value && std::is_integral<B>::value>::type>
+SEQUENCE_CONSTEXPR sequences::range_sequence<typename sequences::detail::range_type<A,B>::type> seq(A a, B b)
 {
-    return {sequences::int_iterator(a), sequences::int_iterator(b+1)};
+    typedef typename sequences::detail::range_type<A,B>::type Int;
+    return {Int(a), Int(b)};
+}
+
+// Constructs an integer range sequence from a to b inclusive, in increments of step
+template<typename A, typename B, typename Step,
+    typename = typename std::enable_if<std::is_integral<A>::value && std::is_integral<B>::value && std::is_integral<Step>::value>::type>
+SEQUENCE_CONSTEXPR sequences::range_sequence<typename sequences::detail::range_type<A,B>::type> seq(A a, B b, Step step)
+{
+    typedef sequences::range_sequence<typename sequences::detail::range_type<A,B>::type> range;
+    return {typename range::value_type(a), typename range::value_type(b), typename range::step_type(step)};
+}
+
+// Constructs an unbounded integer sequence a, a+step, a+2*step, ...
+template<typename Int, typename = typename std::enable_if<std::is_integral<Int>::value>::type>
+SEQUENCE_CONSTEXPR sequences::range_sequence<Int> iota(Int a, typename sequences::range_sequence<Int>::step_type step = 1)
+{
+    return sequences::range_sequence<Int>::with_length(a, sequences::range_sequence<Int>::unbounded, step);
 }
 
 // Constructs a sequence from a C string
@@ -129,10 +280,10 @@ sequences::stored_sequence<T> seq(T && src) { return {std::move(src)}; }
 
 // Constructs a sequence from a pair of pointers
 template<typename T>
-pointer_sequence<T> seq(const T*a, const T *b) { return {a,b}; }
+SEQUENCE_CONSTEXPR pointer_sequence<T> seq(const T*a, const T *b) { return {a,b}; }
 
 // Constructs a sequence from a pair of iterators
-template<typename It>
+template<typename It, typename = typename std::enable_if<!std::is_integral<It>::value>::type>
 sequences::iterator_sequence<It> seq(It a, It b) { return {a,b}; }
 
 // Constructs a sequence from a stream
@@ -142,6 +293,43 @@ sequences::cached_iterator_sequence<std::istreambuf_iterator<T>> seq(std::basic_
     return {{is},{}};
 }
 
+// Zips sequences into a sequence of tuples
+template<typename Seq, typename... Seqs, typename = typename Seq::is_sequence>
+sequences::zip_sequence<typename Seq::stored_type, typename Seqs::stored_type...> zip(const Seq & seq, const Seqs&... seqs)
+{
+    return seq.zip(seqs...);
+}
+
+// Merges sorted sequences into one sorted sequence.
+// The last argument can be a comparator, otherwise the elements are compared using <.
+template<typename Seq1, typename Seq2, typename... Args, typename = typename Seq2::is_sequence>
+typename sequences::detail::merge_sorted_args<Seq1, Seq2, Args...>::result_type merge_sorted(const Seq1 & seq1, const Seq2 & seq2, const Args&... args)
+{
+    return sequences::detail::merge_sorted_args<Seq1, Seq2, Args...>::make(seq1, seq2, args...);
+}
+
+// Merges a sequence of sorted sequences into one sorted sequence
+template<typename Seq, typename = typename Seq::value_type::is_sequence>
+sequences::merge_sorted_sequence<typename Seq::stored_type, std::less<typename Seq::value_type::value_type>> merge_sorted(const Seq & seqs)
+{
+    return seqs.merge_sorted();
+}
+
+// Merges a sequence of sorted sequences into one sorted sequence using a comparator
+template<typename Seq, typename Less, typename = typename Seq::value_type::is_sequence, typename = typename std::enable_if<!sequences::helpers::is_sequence<Less>::value>::type>
+sequences::merge_sorted_sequence<typename Seq::stored_type, Less> merge_sorted(const Seq & seqs, Less less)
+{
+    return seqs.merge_sorted(less);
+}
+
+// Constructs a sequence of base[i] for each index i in a sequence of indices.
+// Elements are prefetched up to distance indices ahead.
+template<typename Seq, typename T, typename = typename Seq::is_sequence>
+sequences::gather_sequence<typename Seq::stored_type, T> gather(const Seq & indices, const T * base, std::size_t distance = 8)
+{
+    return {typename Seq::stored_type(indices.self()), base, distance};
+}
+
 // Constructs an output sequence from a function
 template<typename Fn, typename T>
 sequences::function_inserter<T, Fn> receiver(Fn fn) { return {fn}; }
@@ -156,3 +344,65 @@ sequences::function_inserter<typename Container::value_type, sequences::detail::
 {
     return {sequences::detail::appender<Container>{c}};
 }
+
+// Constructs an output sequence that writes elements to a record file, which can be read using read_records()
+template<typename T>
+sequences::record_output<T> record_writer(const char * path)
+{
+    return sequences::record_output<T>(path);
+}
+
+// Reads a record file. The elements of trivially copyable types are memory-mapped
+// if possible, and the sequence is a pointer_sequence<T>.
+template<typename T>
+sequences::record_file<T> read_records(const char * path)
+{
+    return sequences::record_file<T>(path);
+}
+
+#if SEQUENCE_ENABLE_POSIX
+// Constructs an output sequence that writes elements as text to a file descriptor
+template<typename T>
+sequences::fd_output<T> file_writer(int fd, const char * separator = "\n")
+{
+    return {fd, separator};
+}
+
+// Constructs an output sequence that writes elements as text to a file
+template<typename T>
+sequences::fd_output<T> file_writer(const char * path, const char * separator = "\n")
+{
+    return {path, separator};
+}
+
+// Constructs a sequence of the characters of a file, which is read on a background thread into
+// buffer_count buffers of buffer_size bytes, so that reading overlaps with processing.
+// If hints is true, the kernel is advised that the file is read sequentially, and to read ahead.
+inline sequences::file_source file_reader(const char * path, std::size_t buffer_size = 1<<20, std::size_t buffer_count = 3, bool hints = true)
+{
+    int fd = ::open(path, O_RDONLY);
+    if(fd<0) throw std::runtime_error("Could not open file for reading");
+    return {fd, true, buffer_size, buffer_count, hints};
+}
+
+// Constructs a sequence of the characters read from a file descriptor on a background thread.
+// Files are read from the start on each iteration, but pipes can only be read once.
+inline sequences::file_source file_reader(int fd, std::size_t buffer_size = 1<<20, std::size_t buffer_count = 3, bool hints = true)
+{
+    return {fd, false, buffer_size, buffer_count, hints};
+}
+
+// Constructs an output sequence that writes elements as raw bytes to a file descriptor
+template<typename T>
+sequences::fd_output<T, sequences::binary_format<T>> binary_file_writer(int fd)
+{
+    return {fd, nullptr};
+}
+
+// Constructs an output sequence that writes elements as raw bytes to a file
+template<typename T>
+sequences::fd_output<T, sequences::binary_format<T>> binary_file_writer(const char * path)
+{
+    return {path, nullptr};
+}
+#endif
@@ -0,0 +1,238 @@
+// Implements an arena (a monotonic memory resource) and an allocator that uses it.
+
+namespace sequences
+{
+    // An arena allocates memory from large blocks, and frees all of its memory in one step.
+    // Individual deallocations do nothing.
+    //
+    // An arena can be bound to the current thread using arena_scope, in which case
+    // memory allocated internally by sequences, and by default-constructed arena_allocators,
+    // comes from the arena. Objects allocated from an arena must be destroyed before
+    // the arena is released.
+    //
+    // Arenas are not thread-safe.
+    class arena
+    {
+    public:
+        explicit arena(std::size_t block_size = 64<<10) :
+            blocks(nullptr), ptr(nullptr), end(nullptr), block_size(block_size), allocated(0) {}
+
+        // Uses an initial buffer, for example on the stack, before allocating blocks
+        arena(void * buffer, std::size_t size, std::size_t block_size = 64<<10) :
+            blocks(nullptr), ptr(static_cast<char*>(buffer)), end(static_cast<char*>(buffer)+size),
+            initial(static_cast<char*>(buffer)), initial_end(end), block_size(block_size), allocated(0) {}
+
+        arena(const arena&) = delete;
+        arena & operator=(const arena&) = delete;
+
+        ~arena() { release(); }
+
+        void * allocate(std::size_t size, std::size_t align = alignof(std::max_align_t))
+        {
+            char * p = align_up(ptr, align);
+            if(!p || p + size > end)
+            {
+                // Large allocations get a block of their own
+                std::size_t n = size + align > block_size/4 ? size + align : block_size;
+                char * block = static_cast<char*>(::operator new(sizeof(block_header) + n));
+                block_header * header = reinterpret_cast<block_header*>(block);
+
+                if(n == block_size)
+                {
+                    header->next = blocks;
+                    blocks = header;
+                    ptr = block + sizeof(block_header);
+                    end = ptr + n;
+                    p = align_up(ptr, align);
+                }
+                else
+                {
+                    // Keep using the current block
+                    header->next = blocks ? blocks->next : nullptr;
+                    if(blocks) blocks->next = header; else blocks = header;
+                    p = align_up(block + sizeof(block_header), align);
+                    allocated += size;
+                    return p;
+                }
+            }
+            ptr = p + size;
+            allocated += size;
+            return p;
+        }
+
+        void deallocate(void *, std::size_t) {}
+
+        // Frees all memory allocated from the arena
+        void release()
+        {
+            while(blocks)
+            {
+                block_header * next = blocks->next;
+                ::operator delete(blocks);
+                blocks = next;
+            }
+            ptr = initial;
+            end = initial_end;
+            allocated = 0;
+        }
+
+        // The total number of bytes allocated since the arena was last released
+        std::size_t bytes_allocated() const { return allocated; }
+
+        // The arena bound to the current thread, or nullptr
+        static arena *& current()
+        {
+            static thread_local arena * current_arena = nullptr;
+            return current_arena;
+        }
+
+    private:
+        struct block_header
+        {
+            block_header * next;
+            std::max_align_t padding;
+        };
+
+        block_header * blocks;
+        char *ptr, *end;
+        char *initial = nullptr, *initial_end = nullptr;
+        std::size_t block_size, allocated;
+
+        static char * align_up(char * p, std::size_t align)
+        {
+            return p ? reinterpret_cast<char*>((reinterpret_cast<std::uintptr_t>(p) + align - 1) & ~(std::uintptr_t)(align - 1)) : nullptr;
+        }
+    };
+
+    // Counts the memory allocated for internal buffers on the current thread,
+    // such as the chunks of cached() and the blocks of window().
+    // Only counted if SEQUENCE_ENABLE_ALLOCATION_COUNTERS is enabled.
+    struct allocation_counters
+    {
+        // Allocations from the global heap
+        std::uint64_t heap_allocations, heap_bytes;
+
+        // Allocations from arenas
+        std::uint64_t arena_allocations, arena_bytes;
+
+        // The counters of the current thread
+        static allocation_counters & current()
+        {
+            static thread_local allocation_counters counters = {};
+            return counters;
+        }
+
+        void reset() { *this = allocation_counters(); }
+    };
+
+    namespace detail
+    {
+        inline void count_allocation(std::size_t bytes, bool from_arena)
+        {
+#if SEQUENCE_ENABLE_ALLOCATION_COUNTERS
+            auto & counters = allocation_counters::current();
+            if(from_arena)
+            {
+                ++counters.arena_allocations;
+                counters.arena_bytes += bytes;
+            }
+            else
+            {
+                ++counters.heap_allocations;
+                counters.heap_bytes += bytes;
+            }
+#else
+            (void)bytes;
+            (void)from_arena;
+#endif
+        }
+    }
+
+    // Binds an arena to the current thread for the lifetime of the scope
+    class arena_scope
+    {
+    public:
+        arena_scope(arena & a) : previous(arena::current())
+        {
+            arena::current() = &a;
+        }
+
+        ~arena_scope() { arena::current() = previous; }
+
+        arena_scope(const arena_scope&) = delete;
+        arena_scope & operator=(const arena_scope&) = delete;
+
+    private:
+        arena * previous;
+    };
+
+    // An allocator that allocates from an arena, or from the global heap if there is no arena.
+    // A default-constructed arena_allocator uses the arena bound to the current thread.
+    template<typename T>
+    class arena_allocator
+    {
+    public:
+        typedef T value_type;
+
+        arena_allocator() : source(arena::current()) {}
+
+        arena_allocator(arena & a) : source(&a) {}
+
+        template<typename U>
+        arena_allocator(const arena_allocator<U> & other) : source(other.source) {}
+
+        T * allocate(std::size_t n)
+        {
+            detail::count_allocation(n*sizeof(T), source);
+            return static_cast<T*>(source ? source->allocate(n*sizeof(T), alignof(T)) : ::operator new(n*sizeof(T)));
+        }
+
+        void deallocate(T * p, std::size_t n)
+        {
+            if(source) source->deallocate(p, n*sizeof(T)); else ::operator delete(p);
+        }
+
+        template<typename U>
+        bool operator==(const arena_allocator<U> & other) const { return source == other.source; }
+
+        template<typename U>
+        bool operator!=(const arena_allocator<U> & other) const { return source != other.source; }
+
+        arena * source;
+    };
+
+    namespace detail
+    {
+        // A block of bytes allocated from the current arena, or from the heap
+        class byte_buffer
+        {
+        public:
+            byte_buffer() : data(nullptr), count(0) {}
+
+            explicit byte_buffer(std::size_t size) : data(nullptr), count(0) { reset(size); }
+
+            byte_buffer(byte_buffer && other) : allocator(other.allocator), data(other.data), count(other.count)
+            {
+                other.data = nullptr;
+            }
+
+            ~byte_buffer() { reset(0); }
+
+            void reset(std::size_t size)
+            {
+                if(data) allocator.deallocate(data, count);
+                count = (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+                data = size ? allocator.allocate(count) : nullptr;
+            }
+
+            char * get() const { return reinterpret_cast<char*>(data); }
+
+            explicit operator bool() const { return data; }
+
+        private:
+            arena_allocator<std::max_align_t> allocator;
+            std::max_align_t * data;
+            std::size_t count;
+        };
+    }
+}
@@ -21,7 +21,7 @@ namespace sequences
 
         // Obtain a non-const reference to the derived class.
         // All of the const methods basically lie as they do actually modify some internal state.
-        Derived & self() const { return *const_cast<Derived*>(static_cast<const Derived*>(this)); }
+        SEQUENCE_CONSTEXPR Derived & self() const { return *const_cast<Derived*>(static_cast<const Derived*>(this)); }
 
         // Create a virtual sequence from this sequence - one enumerated via virtual functions
         virtual_sequence<T, Stored> make_virtual() const { return {self()}; }
@@ -30,70 +30,98 @@ namespace sequences
 
         // The default size() computation is O(n) but it can be overridden in
         // derived classes for an O(1) implementation
-        size_type size() const
+        SEQUENCE_CONSTEXPR size_type size() const
         {
-            size_type c=0;
-            for(auto i=self().first(); i; i=self().next()) ++c;
-            return c;
+            return size(helpers::is_blockwise<Derived>());
         }
 
+        // An input iterator, which shares the evaluation of the sequence.
+        // Use range() for iterators that can be copied independently.
         struct iterator
         {
             typedef T value_type;
-            Derived & underlying;
-            const value_type * current;
-
-            typedef value_type & reference;
-            typedef value_type & pointer;
-            typedef std::size_t size_type;
-            typedef int difference_type;
+            typedef const value_type & reference;
+            typedef const value_type * pointer;
+            typedef std::ptrdiff_t difference_type;
             typedef std::input_iterator_tag iterator_category;
 
+            Derived * underlying;
+            const value_type * current;
+
             const value_type & operator*() const { return *current; }
 
+            const value_type * operator->() const { return current; }
+
             iterator & operator++()
             {
-                current = underlying.next();
+                current = underlying->next();
                 return *this;
             }
 
-            bool operator!=(iterator other) const { return current!=other.current; }
+            void operator++(int) { ++*this; }
+
+            bool operator==(const iterator & other) const { return current==other.current; }
+
+            bool operator!=(const iterator & other) const { return current!=other.current; }
         };
 
         typedef iterator const_iterator;
 
-        iterator begin() const { return {self(), self().first()}; }
+        iterator begin() const { return {&self(), self().first()}; }
 
-        iterator end() const { return {self(), nullptr}; }
+        iterator end() const { return {&self(), nullptr}; }
 
         const_iterator cbegin() const { return begin(); }
 
         const_iterator cend() const { return end(); }
 
+        // A range with standard iterators, which can be used with standard algorithms and std::ranges.
+        // Contiguous sequences give random-access iterators, and sequences whose copies can be
+        // iterated independently give forward iterators. Other sequences are returned as they are.
+        // Ranges of contiguous sequences point into the sequence's data, so are valid while it exists.
+        template<typename D=Derived>
+        typename std::conditional<helpers::is_contiguous<D>::value, contiguous_range<T>,
+            typename std::conditional<helpers::is_forward<D>::value, forward_range<Stored>, Stored>::type>::type
+        range() const
+        {
+            return range(std::integral_constant<int, helpers::is_contiguous<D>::value ? 2 : helpers::is_forward<D>::value ? 1 : 0>());
+        }
+
         template<typename Predicate>
-        where_sequence<T, Stored, Predicate> where(Predicate p) const
+        SEQUENCE_CONSTEXPR where_sequence<T, Stored, Predicate> where(Predicate p) const
         {
             return {self(), p};
         }
 
         template<typename Fn>
-        select_sequence<T, Stored, Fn> select(Fn fn) const
+        SEQUENCE_CONSTEXPR select_sequence<T, Stored, Fn> select(Fn fn) const
+        {
+            return {self(), fn};
+        }
+
+        // Maps each element to a sequence, and flattens the result.
+        // fn either returns a sequence, or writes elements to an output_sequence
+        // passed as its second parameter.
+        template<typename Fn>
+        typename std::conditional<helpers::is_callable<Fn, const T&>::value,
+            select_many_sequence<Stored, Fn>,
+            select_many_output_sequence<Stored, Fn>>::type select_many(Fn fn) const
         {
             return {self(), fn};
         }
 
-        take_sequence<T, Stored> take(int n) const
+        SEQUENCE_CONSTEXPR take_sequence<T, Stored> take(int n) const
         {
             return {self(), n};
         }
 
-        skip_sequence<T, Stored> skip(int n) const
+        SEQUENCE_CONSTEXPR skip_sequence<T, Stored> skip(int n) const
         {
             return {self(), n};
         }
 
         template<typename Aggregate>
-        T aggregate(Aggregate agg) const
+        SEQUENCE_CONSTEXPR T aggregate(Aggregate agg) const
         {
             T result = {};
             for(const value_type * i=self().first(); i; i=self().next())
@@ -102,7 +130,7 @@ namespace sequences
         }
 
         template<typename Aggregate, typename U>
-        U aggregate(U result, Aggregate agg) const
+        SEQUENCE_CONSTEXPR U aggregate(U result, Aggregate agg) const
         {
             for(const value_type * i=self().first(); i; i=self().next())
                 result = agg(result, *i);
@@ -110,19 +138,19 @@ namespace sequences
         }
 
         template<typename Aggregate, typename U>
-        U accumulate(U result, Aggregate agg) const
+        SEQUENCE_CONSTEXPR U accumulate(U result, Aggregate agg) const
         {
             for(const value_type * i=self().first(); i; i=self().next())
                 agg(result, *i);
             return result;
         }
 
-        T sum() const
+        SEQUENCE_CONSTEXPR T sum() const
         {
-            return aggregate([](const T &i1, const T&i2) { return i1+i2; });
+            return sum(helpers::is_blockwise<Derived>());
         }
 
-        const T &at(size_type index) const
+        SEQUENCE_CONSTEXPR const T &at(size_type index) const
         {
             for(auto c = self().first(); c; c=self().next())
             {
@@ -140,22 +168,20 @@ namespace sequences
             return value;
         }
 
-        const value_type &front() const
+        SEQUENCE_CONSTEXPR const value_type &front() const
         {
             auto c = self().first();
             if(!c) throw std::out_of_range("front() called on an empty list");
             return *c;
         }
 
+        // back() is O(1) for sequences that can be iterated backwards,
+        // and O(n) otherwise.
         const value_type &back() const
         {
-            for(auto c = self().first(); c;)
-            {
-                auto c2 = self().next();
-                if(!c2) return *c;
-                c = c2;
-            }
-            throw std::out_of_range("back() called on an empty list");
+            auto c = find_last(helpers::is_reversible<Derived>());
+            if(!c) throw std::out_of_range("back() called on an empty list");
+            return *c;
         }
 
         template<typename T2, typename Derived2,typename Stored2>
@@ -228,6 +254,123 @@ namespace sequences
         }
 
     private:
+        contiguous_range<T> range(std::integral_constant<int,2>) const
+        {
+            return {self().data(), self().data() + self().size()};
+        }
+
+        forward_range<Stored> range(std::integral_constant<int,1>) const
+        {
+            return forward_range<Stored>(self());
+        }
+
+        Stored range(std::integral_constant<int,0>) const
+        {
+            return self();
+        }
+
+        SEQUENCE_CONSTEXPR size_type size(std::false_type) const
+        {
+            size_type c=0;
+            for(auto i=self().first(); i; i=self().next()) ++c;
+            return c;
+        }
+
+        SEQUENCE_CONSTEXPR size_type size(std::true_type) const
+        {
+            return helpers::constant_evaluated() ? size(std::false_type()) : count_blocks(helpers::is_masked<Derived>());
+        }
+
+        SEQUENCE_CONSTEXPR T sum(std::false_type) const
+        {
+            return aggregate([](const T &i1, const T&i2) { return i1+i2; });
+        }
+
+        SEQUENCE_CONSTEXPR T sum(std::true_type) const
+        {
+            return helpers::constant_evaluated() ? sum(std::false_type()) : block_sum(helpers::is_masked<Derived>());
+        }
+
+        // Counts the elements of a blockwise sequence
+        size_type count_blocks(std::false_type) const
+        {
+            T buffer[helpers::block_size];
+            std::size_t n = helpers::block_size;
+            size_type c = 0;
+            for(self().first_block(buffer, n); n; self().next_block(buffer, n = helpers::block_size))
+                c += n;
+            return c;
+        }
+
+        // Counts the selected elements of a masked sequence, without compacting them
+        size_type count_blocks(std::true_type) const
+        {
+            T buffer[helpers::block_size];
+            typename detail::lane_mask<T>::type mask[helpers::block_size];
+            std::size_t n = helpers::block_size;
+            size_type c = 0;
+            for(self().first_masked_block(buffer, mask, n); n; self().next_masked_block(buffer, mask, n = helpers::block_size))
+                detail::for_each_lane(n, [&](std::size_t i) { c += mask[i] & 1; });
+            return c;
+        }
+
+        // Sums a blockwise sequence a block at a time
+        T block_sum(std::false_type) const
+        {
+            T buffer[helpers::block_size];
+            std::size_t n = helpers::block_size;
+            T total = T();
+            for(auto block = self().first_block(buffer, n); n; block = self().next_block(buffer, n = helpers::block_size))
+                detail::for_each_lane(n, [&](std::size_t i) { total += block[i]; });
+            return total;
+        }
+
+        // Sums the selected elements of a masked sequence
+        T block_sum(std::true_type) const
+        {
+            T buffer[helpers::block_size];
+            typename detail::lane_mask<T>::type mask[helpers::block_size];
+            std::size_t n = helpers::block_size;
+            T total = T();
+            for(auto block = self().first_masked_block(buffer, mask, n); n; block = self().next_masked_block(buffer, mask, n = helpers::block_size))
+                detail::for_each_lane(n, [&](std::size_t i) { total += detail::masked(block[i], mask[i]); });
+            return total;
+        }
+
+        // Finds the last element of the sequence
+        const value_type * find_last(std::true_type) const
+        {
+            return self().last();
+        }
+
+        const value_type * find_last(std::false_type) const
+        {
+            for(auto c = self().first(); c;)
+            {
+                auto c2 = self().next();
+                if(!c2) return c;
+                c = c2;
+            }
+            return nullptr;
+        }
+
+        // Computes the exact length of a joined string
+        template<typename String>
+        void reserve_join(String & result, std::size_t separator_length, std::true_type) const
+        {
+            typedef helpers::join_traits<T> traits;
+            std::size_t length = 0;
+            for(auto i = self().first(); i; i = self().next())
+                length += traits::size(*i) + separator_length;
+            if(length) result.reserve(length - separator_length);
+        }
+
+        // Single-pass sequences rely on the string's geometric growth
+        template<typename String>
+        void reserve_join(String &, std::size_t, std::false_type) const
+        {
+        }
+
         // Helper function to convert sequence to a different type
         template<typename U>
         struct asFn
@@ -253,12 +396,12 @@ namespace sequences
             return {self(), {}};
         }
 
-        bool any() const { return self().first(); }
+        SEQUENCE_CONSTEXPR bool any() const { return self().first(); }
 
         template<typename Predicate>
-        bool any(Predicate p) const { return where(p).any(); }
+        SEQUENCE_CONSTEXPR bool any(Predicate p) const { return where(p).any(); }
 
-        bool empty() const { return !any(); }
+        SEQUENCE_CONSTEXPR bool empty() const { return !any(); }
 
         // Return the first item, or 'value'.
         // Returns by value (not by reference) to avoid dangers of dangling references.
@@ -273,25 +416,219 @@ namespace sequences
         // Returns by value (not by reference) to avoid dangers of dangling references.
         value_type back_or_default(const value_type & value) const
         {
-            for(auto c = self().first(); c;)
-            {
-                auto c2 = self().next();
-                if(!c2) return *c;
-                c = c2;
-            }
-            return value;
+            auto c = find_last(helpers::is_reversible<Derived>());
+            return c ? *c : value;
         }
 
-        template<typename Predicate>
-        size_type count(Predicate p)
+        // Reverses the sequence.
+        // Sequences that can be iterated backwards are reversed in place,
+        // otherwise the elements are buffered each time the sequence is iterated.
+        template<typename S=Stored>
+        typename std::conditional<helpers::is_reversible<S>::value, reverse_sequence<S>, reverse_buffer_sequence<S>>::type reverse() const
+        {
+            return {self()};
+        }
+
+        template<typename Predicate, typename = typename std::enable_if<helpers::is_callable<Predicate, const T&>::value>::type>
+        SEQUENCE_CONSTEXPR size_type count(Predicate p)
         {
             return where(p).size();
         }
 
+        // The index returned by index_of() if the value is not found
+        static const size_type npos = size_type(-1);
+
+        // Counts the elements equal to value.
+        // Contiguous bytes are counted using SIMD kernels.
+        size_type count(const T & value) const
+        {
+            return count_value(value, helpers::is_contiguous<Derived>());
+        }
+
+        // Returns the sequence starting at the first element equal to value, or an empty sequence.
+        // Contiguous sequences return a pointer_sequence, and bytes are searched using memchr().
+        template<typename D=Derived>
+        typename std::conditional<helpers::is_contiguous<D>::value,
+            pointer_sequence<T>,
+            skip_until_sequence<Stored, helpers::equal_to_value<T>>>::type
+        find(const T & value) const
+        {
+            return find(value, helpers::is_contiguous<D>());
+        }
+
+        bool contains(const T & value) const
+        {
+            return self().index_of(value) != npos;
+        }
+
+        // The index of the first element equal to value, or npos
+        size_type index_of(const T & value) const
+        {
+            return index_of(value, helpers::is_contiguous<Derived>());
+        }
+
+        // Returns the sequence starting at the first element contained in set, or an empty sequence.
+        // Contiguous bytes are searched using a lookup table, or SIMD kernels for sets of up to 8 bytes.
+        template<typename Set, typename D=Derived, typename = typename Set::is_sequence>
+        typename std::conditional<helpers::is_contiguous<D>::value,
+            pointer_sequence<T>,
+            skip_until_sequence<Stored, helpers::member_of<typename Set::stored_type>>>::type
+        find_first_of(const Set & set) const
+        {
+            return find_first_of(set, helpers::is_contiguous<D>());
+        }
+
+    private:
+        pointer_sequence<T> find(const T & value, std::true_type) const
+        {
+            auto begin = self().data(), end = begin + self().size();
+            return {detail::find_value(begin, end, value, helpers::is_byte<T>()), end};
+        }
+
+        skip_until_sequence<Stored, helpers::equal_to_value<T>> find(const T & value, std::false_type) const
+        {
+            return skip_until(helpers::equal_to_value<T>{value});
+        }
+
+        size_type index_of(const T & value, std::true_type) const
+        {
+            auto begin = self().data(), end = begin + self().size();
+            auto found = detail::find_value(begin, end, value, helpers::is_byte<T>());
+            return found==end ? npos : found-begin;
+        }
+
+        size_type index_of(const T & value, std::false_type) const
+        {
+            size_type index = 0;
+            for(auto i = self().first(); i; i = self().next(), ++index)
+                if(*i == value) return index;
+            return npos;
+        }
+
+        size_type count_value(const T & value, std::true_type) const
+        {
+            auto begin = self().data();
+            return detail::count_value(begin, begin + self().size(), value, helpers::is_byte<T>());
+        }
+
+        size_type count_value(const T & value, std::false_type) const
+        {
+            size_type count = 0;
+            for(auto i = self().first(); i; i = self().next())
+                count += *i == value;
+            return count;
+        }
+
+        template<typename Set>
+        pointer_sequence<T> find_first_of(const Set & set, std::true_type) const
+        {
+            auto begin = self().data(), end = begin + self().size();
+            return {detail::find_first_of(begin, end, set, helpers::is_byte<T>()), end};
+        }
+
+        template<typename Set>
+        skip_until_sequence<Stored, helpers::member_of<typename Set::stored_type>> find_first_of(const Set & set, std::false_type) const
+        {
+            return skip_until(helpers::member_of<typename Set::stored_type>{set});
+        }
+
+    public:
+
         template<typename Seq2, typename Fn, typename = typename Seq2::is_sequence>
-        merge_sequence<Stored, typename Seq2::stored_type, Fn> merge(Seq2 seq2, Fn fn) const
+        merge_sequence<Stored, typename Seq2::stored_type, Fn> merge(const Seq2 & seq2, Fn fn) const
+        {
+            return {self(), typename Seq2::stored_type(seq2.self()), fn};
+        }
+
+        // Zips this sequence with other sequences, yielding tuples of elements.
+        // The sequence ends when any sequence ends.
+        template<typename... Seqs>
+        zip_sequence<Stored, typename Seqs::stored_type...> zip(const Seqs&... seqs) const
+        {
+            return {self(), typename Seqs::stored_type(seqs.self())...};
+        }
+
+        // Lazily computes the elements in either sequence.
+        // Both sequences must be sorted.
+        template<typename Seq2, typename Less = std::less<T>, typename = typename Seq2::is_sequence>
+        set_sequence<Stored, typename Seq2::stored_type, Less, set_operation::union_of> set_union(const Seq2 & seq2, Less less = Less()) const
+        {
+            return {self(), seq2.self(), less};
+        }
+
+        // Lazily computes the elements in both sequences.
+        // Both sequences must be sorted.
+        template<typename Seq2, typename Less = std::less<T>, typename = typename Seq2::is_sequence>
+        set_sequence<Stored, typename Seq2::stored_type, Less, set_operation::intersection> set_intersection(const Seq2 & seq2, Less less = Less()) const
+        {
+            return {self(), seq2.self(), less};
+        }
+
+        // Lazily computes the elements of this sequence that are not in seq2.
+        // Both sequences must be sorted.
+        template<typename Seq2, typename Less = std::less<T>, typename = typename Seq2::is_sequence>
+        set_sequence<Stored, typename Seq2::stored_type, Less, set_operation::difference> set_difference(const Seq2 & seq2, Less less = Less()) const
+        {
+            return {self(), seq2.self(), less};
+        }
+
+        // Lazily computes the elements in exactly one of the sequences.
+        // Both sequences must be sorted.
+        template<typename Seq2, typename Less = std::less<T>, typename = typename Seq2::is_sequence>
+        set_sequence<Stored, typename Seq2::stored_type, Less, set_operation::symmetric_difference> set_symmetric_difference(const Seq2 & seq2, Less less = Less()) const
+        {
+            return {self(), seq2.self(), less};
+        }
+
+        // Groups the elements into consecutive chunks of n elements, as pointer_sequences.
+        // Contiguous sequences are not copied.
+        chunk_sequence<Stored> chunk(std::size_t n) const
+        {
+            return {self(), n};
+        }
+
+        // Yields windows of w consecutive elements, starting every step elements.
+        // Each window is a pointer_sequence that is valid until the next window.
+        window_sequence<Stored> window(std::size_t w, std::size_t step = 1) const
+        {
+            return {self(), w, step};
+        }
+
+        // Yields consecutive non-overlapping windows of n elements
+        window_sequence<Stored> tumbling(std::size_t n) const
+        {
+            return {self(), n, n};
+        }
+
+        // The sum of each window of w elements
+        rolling_sequence<Stored, detail::rolling_sum<T>> rolling_sum(std::size_t w) const
+        {
+            return {self(), w};
+        }
+
+        // The mean of each window of w elements
+        rolling_sequence<Stored, detail::rolling_mean<T>> rolling_mean(std::size_t w) const
         {
-            return {self(), seq2, fn};
+            return {self(), w};
+        }
+
+        // The smallest element in each window of w elements
+        rolling_sequence<Stored, detail::rolling_extreme<T, std::less<T>>> rolling_min(std::size_t w) const
+        {
+            return {self(), w};
+        }
+
+        // The largest element in each window of w elements
+        rolling_sequence<Stored, detail::rolling_extreme<T, std::greater<T>>> rolling_max(std::size_t w) const
+        {
+            return {self(), w};
+        }
+
+        // Merges a sequence of sorted sequences into one sorted sequence
+        template<typename U = T, typename Less = std::less<typename U::value_type>>
+        merge_sorted_sequence<Stored, Less> merge_sorted(Less less = Less()) const
+        {
+            return {self(), less};
         }
 
         template<typename Predicate>
@@ -307,36 +644,152 @@ namespace sequences
         }
 
         template<typename Seq2, typename = typename Seq2::is_sequence>
-        concat_sequence<stored_type, typename Seq2::stored_type> concat(Seq2 seq2) const
+        concat_sequence<stored_type, typename Seq2::stored_type> concat(const Seq2 & seq2) const
         {
-            return {self(), seq2};
+            return {self(), typename Seq2::stored_type(seq2.self())};
         }
 
         template<typename Seq2, typename = typename Seq2::is_sequence>
-        concat_sequence<stored_type, typename Seq2::stored_type> operator+(Seq2 seq2) const
+        concat_sequence<stored_type, typename Seq2::stored_type> operator+(const Seq2 & seq2) const
         {
-            return {self(), seq2};
+            return {self(), typename Seq2::stored_type(seq2.self())};
+        }
+
+        // Concatenates a sequence of strings or characters into a string,
+        // with an optional separator between each element.
+        // If the sequence can be iterated twice cheaply, the exact length of the string
+        // is computed first, so the string is only allocated once.
+        template<typename U = T>
+        std::basic_string<typename helpers::join_traits<U>::char_type> join(const typename helpers::join_traits<U>::char_type * separator = nullptr) const
+        {
+            typedef helpers::join_traits<U> traits;
+            std::size_t separator_length = separator ? std::char_traits<typename traits::char_type>::length(separator) : 0;
+
+            std::basic_string<typename traits::char_type> result;
+            reserve_join(result, separator_length, helpers::is_multipass<Derived>());
+
+            auto i = self().first();
+            if(i)
+            {
+                traits::append(result, *i);
+                if(separator_length)
+                {
+                    while((i = self().next()))
+                    {
+                        result.append(separator, separator_length);
+                        traits::append(result, *i);
+                    }
+                }
+                else
+                {
+                    while((i = self().next()))
+                        traits::append(result, *i);
+                }
+            }
+            return result;
         }
 
         // Writes the sequence to the output sequence
         template<typename U>
         void write_to(const output_sequence<U> & out) const
         {
-            for(auto &i: *this) out.add(i);
+            out << self();
         }
 
-        // Writes the sequence to the container
+        // Writes the sequence to the container.
+        // Reserves space when the size is known, and uses emplace_hint() for associative containers.
         template<typename Container>
         void write_to(Container &c) const
         {
-            for(auto &i: *this) c.insert(c.end(), i);
+            function_inserter<typename Container::value_type, detail::appender<Container>>{detail::appender<Container>{c}} << self();
+        }
+
+#if SEQUENCE_ENABLE_PROFILING
+        // Measures the elements and time of the pipeline up to this point, which are reported
+        // by the profiler under the given name. Stages between two probes are reported
+        // with the elements in and out of them, and their selectivity.
+        probe_sequence<Stored> probe(const char * name, profiler & p = profiler::current()) const
+        {
+            return {self(), p.stage(name)};
+        }
+#else
+        // Profiling is disabled, so probes are not part of the pipeline
+        Stored probe(const char *) const { return self(); }
+
+        Stored probe(const char *, profiler &) const { return self(); }
+#endif
+
+        // Reads up to distance elements ahead, prefetching the memory that elements
+        // which are pointers point to, so that dereferencing them later does not stall on a cache miss.
+        // Elements of containers, such as the nodes of a std::map, are prefetched themselves.
+        template<typename U = Stored>
+        prefetch_sequence<U, detail::element_address<helpers::is_stable<U>::value>> prefetch(std::size_t distance = 8) const
+        {
+            return {self(), distance, detail::element_address<helpers::is_stable<U>::value>()};
+        }
+
+        // Reads up to distance elements ahead, prefetching address(element) for each element.
+        // The address function returns a pointer, or nullptr to prefetch nothing.
+        template<typename Address>
+        prefetch_sequence<Stored, Address> prefetch(std::size_t distance, Address address) const
+        {
+            return {self(), distance, address};
+        }
+
+        // Computes a hash or checksum of a sequence of bytes, for example
+        // hash<sequences::crc32c>(), hash<sequences::fnv1a64>() or hash(sequences::xxhash64(seed)).
+        // Contiguous data, chunks and blocks are hashed in bulk.
+        template<typename Hash>
+        typename Hash::result_type hash(const Hash & h = Hash()) const
+        {
+            hash_output<Hash, T> out(h);
+            out << self();
+            return out.value();
+        }
+
+        // Pairs each element with a 64-bit hash of it, as (hash, element),
+        // which can be used to partition or deduplicate elements
+        template<typename Hash = key_hash<T>>
+        select_sequence<T, Stored, detail::hash_pair<T, Hash>> hashed(Hash h = Hash()) const
+        {
+            return {self(), {h}};
+        }
+
+        // Copies the elements into a std::array, which can be used to build tables at compile time.
+        // Throws std::length_error if the sequence does not have exactly N elements.
+        // Iterates a copy of the sequence, because some compilers cannot evaluate
+        // pointers into temporaries of constant initializers.
+        template<std::size_t N>
+        SEQUENCE_CONSTEXPR std::array<T, N> to_array() const
+        {
+            std::array<T, N> result{};
+            std::size_t i = 0;
+            Derived copy = self();
+            for(auto c = copy.first(); c; c = copy.next())
+            {
+                if(i == N) throw std::length_error("to_array() sequence is too long");
+                result[i++] = *c;
+            }
+            if(i != N) throw std::length_error("to_array() sequence is too short");
+            return result;
         }
 
         // Creates a container containing the elements of the sequence
         template<typename Container>
         Container make()
         {
-            return {begin(), end()};
+            Container c;
+            write_to(c);
+            return c;
+        }
+
+        // Creates a container using the given allocator, for example an arena_allocator
+        template<typename Container>
+        Container make(const typename Container::allocator_type & alloc)
+        {
+            Container c(alloc);
+            write_to(c);
+            return c;
         }
 
         repeat_sequence<Stored> repeat(int n) const
@@ -344,9 +797,37 @@ namespace sequences
             return {self(), n};
         }
 
-        split_sequence<Stored> split(const T * splitChars) const
+        split_sequence<Stored, std::allocator<T>> split(const T * splitChars) const
         {
             return {self(), splitChars};
         }
+
+        // Splits the sequence into tokens, allocated using the given allocator,
+        // for example an arena_allocator<T>
+        template<typename Alloc>
+        split_sequence<Stored, Alloc> split(const T * splitChars, const Alloc & alloc) const
+        {
+            return {self(), splitChars, alloc};
+        }
+
+        // Caches the elements of this sequence the first time it is iterated,
+        // so that subsequent iterations do not re-evaluate the sequence.
+        cached_sequence<Stored> cached() const
+        {
+            return {self()};
+        }
+
+        // Caches the elements of this sequence the first time it is iterated,
+        // keeping around memory_budget bytes in memory and writing the rest to a file.
+        // The file is created at path, which must not already exist, and is deleted when the
+        // sequence is destroyed. If path is nullptr, or a directory if SEQUENCE_ENABLE_POSIX is defined,
+        // a temporary file is created instead.
+        spill_sequence<Stored> spill(const char * path = nullptr, std::size_t memory_budget = 64<<20) const
+        {
+            return {self(), path, memory_budget};
+        }
     };
+
+    template<typename T, typename Derived, typename Stored>
+    const typename base_sequence<T, Derived, Stored>::size_type base_sequence<T, Derived, Stored>::npos;
 }
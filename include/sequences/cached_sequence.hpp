@@ -0,0 +1,98 @@
+// Implements a sequence that caches the elements of another sequence.
+
+namespace sequences
+{
+    // Evaluates the underlying sequence at most once, storing the elements
+    // in a chunked buffer so that later iterations read from memory.
+    // Elements are pulled from the underlying sequence on demand, so a partially
+    // iterated cache resumes where it stopped.
+    //
+    // Copies of a cached_sequence share the same cache, and each copy can be
+    // iterated in a different thread.
+    template<typename Seq>
+    class cached_sequence : public base_sequence<typename Seq::value_type, cached_sequence<Seq>>
+    {
+    public:
+        typedef typename Seq::value_type value_type;
+        typedef void is_multipass;
+        typedef void is_forward;
+
+        cached_sequence(const Seq & seq) : data(std::allocate_shared<cache>(arena_allocator<cache>(), seq)), current(nullptr) {}
+
+        const value_type * first()
+        {
+            position = 0;
+            current = nullptr;
+            return fetch();
+        }
+
+        const value_type * next()
+        {
+            ++position;
+            return fetch();
+        }
+
+        // Evaluates the entire sequence
+        std::size_t size() const
+        {
+            return data->fill(-1);
+        }
+
+    private:
+        struct cache
+        {
+            cache(const Seq & seq) : seq(seq), available(0), started(false), complete(false) {}
+
+            Seq seq;
+            chunked_buffer<value_type> buffer;
+            std::mutex mutex;
+
+            // The number of elements that can be read without locking
+            std::atomic<std::size_t> available;
+            bool started, complete;
+
+            // Pulls elements from the underlying sequence until there are more than n elements,
+            // and returns the number of elements available.
+            std::size_t fill(std::size_t n)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                std::size_t count = available.load(std::memory_order_relaxed);
+                while(count <= n && !complete)
+                {
+                    const value_type * item = started ? seq.next() : seq.first();
+                    started = true;
+                    if(item)
+                    {
+                        buffer.push_back(*item);
+                        available.store(++count, std::memory_order_release);
+                    }
+                    else
+                        complete = true;
+                }
+                return count;
+            }
+        };
+
+        std::shared_ptr<cache> data;
+        const typename chunked_buffer<value_type>::chunk * current;
+        std::size_t index, position;
+
+        const value_type * fetch()
+        {
+            if(position >= data->available.load(std::memory_order_acquire) && position >= data->fill(position))
+                return nullptr;
+
+            if(!current)
+            {
+                current = data->buffer.head_chunk();
+                index = 0;
+            }
+            else if(++index == current->capacity)
+            {
+                current = current->next;
+                index = 0;
+            }
+            return current->items + index;
+        }
+    };
+}
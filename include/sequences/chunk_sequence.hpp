@@ -0,0 +1,122 @@
+// Implements a sequence that groups the elements of another sequence into chunks.
+
+namespace sequences
+{
+    // Yields consecutive chunks of n elements, as pointer_sequences.
+    // The last chunk may be smaller.
+    //
+    // Chunks of contiguous sequences point directly into the underlying data, without copying.
+    // Otherwise the elements are copied into a buffer that is reused for each chunk,
+    // so a chunk is only valid until the next chunk is requested.
+    template<typename Seq>
+    class chunk_sequence : public base_sequence<pointer_sequence<typename Seq::value_type>, chunk_sequence<Seq>>
+    {
+    public:
+        typedef typename Seq::value_type element_type;
+        typedef pointer_sequence<element_type> value_type;
+        typedef void is_chunked;
+        typedef typename std::conditional<helpers::is_sized<Seq>::value, void, int>::type is_sized;
+        typedef typename std::conditional<helpers::is_multipass<Seq>::value, void, int>::type is_multipass;
+
+        chunk_sequence(const Seq & seq, std::size_t n) : seq(seq), n(n), filled(0), current(nullptr, nullptr)
+        {
+            if(n==0) throw std::invalid_argument("chunk() size must be positive");
+        }
+
+        // Copies do not copy the buffer
+        chunk_sequence(const chunk_sequence & other) : seq(other.seq), n(other.n), filled(0), current(nullptr, nullptr) {}
+
+        chunk_sequence & operator=(const chunk_sequence&) = delete;
+
+        ~chunk_sequence()
+        {
+            for(std::size_t i=0; i<filled; ++i)
+                buffer()[i].~element_type();
+        }
+
+        const value_type * first()
+        {
+            return first(contiguous());
+        }
+
+        const value_type * next()
+        {
+            return next(contiguous());
+        }
+
+        // The number of elements in each chunk
+        std::size_t chunk_size() const { return n; }
+
+        // The number of chunks
+        std::size_t size() const
+        {
+            std::size_t count = seq.size();
+            return (count + n - 1) / n;
+        }
+
+    private:
+        Seq seq;
+        std::size_t n, filled;
+        value_type current;
+
+        // Used by contiguous sequences: the remaining data
+        const element_type *position, *limit;
+
+        // Used by other sequences: the reused buffer
+        detail::byte_buffer storage;
+        bool started, exhausted;
+
+        typedef std::integral_constant<bool, helpers::is_contiguous<Seq>::value> contiguous;
+
+        element_type * buffer() const { return reinterpret_cast<element_type*>(storage.get()); }
+
+        const value_type * first(std::true_type)
+        {
+            position = seq.data();
+            limit = position + seq.size();
+            return next(std::true_type());
+        }
+
+        const value_type * next(std::true_type)
+        {
+            if(position == limit) return nullptr;
+            const element_type * from = position;
+            position = std::size_t(limit - position) > n ? position + n : limit;
+            current = value_type(from, position);
+            return &current;
+        }
+
+        const value_type * first(std::false_type)
+        {
+            if(!storage) storage.reset(n*sizeof(element_type));
+            started = exhausted = false;
+            return next(std::false_type());
+        }
+
+        const value_type * next(std::false_type)
+        {
+            if(exhausted) return nullptr;
+            const element_type * item = started ? seq.next() : seq.first();
+            started = true;
+
+            std::size_t count = 0;
+            while(item)
+            {
+                if(count < filled)
+                    buffer()[count] = *item;
+                else
+                {
+                    new(buffer() + count) element_type(*item);
+                    ++filled;
+                }
+                if(++count == n) break;
+                item = seq.next();
+            }
+
+            if(!item) exhausted = true;
+            if(count==0) return nullptr;
+            current = value_type(buffer(), buffer() + count);
+            return &current;
+        }
+    };
+}
@@ -0,0 +1,119 @@
+// Implements an append-only buffer made of a linked list of chunks.
+// Elements are never moved or reallocated once added, so pointers to
+// elements remain valid until the buffer is cleared or destroyed.
+// Chunks are allocated from the arena that is current when the buffer is created.
+
+namespace sequences
+{
+    template<typename T>
+    class chunked_buffer
+    {
+    public:
+        struct chunk
+        {
+            chunk *prev, *next;
+            std::size_t size, capacity;
+            T * items;
+        };
+
+        chunked_buffer() : head(nullptr), tail(nullptr), count(0) {}
+
+        // Copying a buffer does not copy its contents, since buffers
+        // are owned by sequences that refill them on demand.
+        chunked_buffer(const chunked_buffer &) : chunked_buffer() {}
+
+        chunked_buffer & operator=(const chunked_buffer &) { clear(); return *this; }
+
+        ~chunked_buffer()
+        {
+            clear();
+            for(chunk * c = head; c;)
+            {
+                chunk * n = c->next;
+                allocator.deallocate(reinterpret_cast<std::max_align_t*>(c), blocks(c->capacity));
+                c = n;
+            }
+        }
+
+        // Removes all elements, but keeps the chunks for reuse
+        void clear()
+        {
+            for(chunk * c = head; c; c=c->next)
+            {
+                for(std::size_t i=0; i<c->size; ++i)
+                    c->items[i].~T();
+                c->size = 0;
+            }
+            tail = head;
+            count = 0;
+        }
+
+        const T * push_back(const T & item)
+        {
+            if(!tail || tail->size == tail->capacity) grow();
+            T * result = new(tail->items + tail->size) T(item);
+            ++tail->size;
+            ++count;
+            return result;
+        }
+
+        std::size_t size() const { return count; }
+
+        bool empty() const { return count==0; }
+
+        // The first chunk, or nullptr if there are no elements
+        const chunk * first_chunk() const { return count ? head : nullptr; }
+
+        // The last non-empty chunk, or nullptr if there are no elements
+        const chunk * last_chunk() const { return count ? tail : nullptr; }
+
+        // The first chunk, which may be empty.
+        // Each chunk is filled to its capacity before the next chunk is used,
+        // so readers can walk the chunks concurrently with push_back(),
+        // provided that they only read elements that have already been added.
+        const chunk * head_chunk() const { return head; }
+
+    private:
+        chunk *head, *tail;
+        std::size_t count;
+        arena_allocator<std::max_align_t> allocator;
+
+        // Chunks grow geometrically up to around 1MB each
+        static const std::size_t initial_bytes = 512, max_bytes = 1<<20;
+
+        // The items are stored immediately after the chunk header
+        static std::size_t header_size()
+        {
+            return (sizeof(chunk) + alignof(T) - 1) / alignof(T) * alignof(T);
+        }
+
+        // The number of aligned blocks needed for a chunk
+        static std::size_t blocks(std::size_t capacity)
+        {
+            return (header_size() + capacity*sizeof(T) + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+        }
+
+        void grow()
+        {
+            if(tail && tail->next)
+            {
+                tail = tail->next;
+                return;
+            }
+
+            std::size_t capacity = tail ? tail->capacity*2 : initial_bytes/sizeof(T);
+            if(capacity*sizeof(T) > max_bytes) capacity = max_bytes/sizeof(T);
+            if(capacity==0) capacity = 1;
+
+            chunk * c = reinterpret_cast<chunk*>(allocator.allocate(blocks(capacity)));
+            c->prev = tail;
+            c->next = nullptr;
+            c->size = 0;
+            c->capacity = capacity;
+            c->items = reinterpret_cast<T*>(reinterpret_cast<char*>(c) + header_size());
+
+            if(tail) tail->next = c; else head = c;
+            tail = c;
+        }
+    };
+}
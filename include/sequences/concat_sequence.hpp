@@ -34,6 +34,32 @@ namespace sequences
             return seq2.next();
         }
 
+        typedef typename std::conditional<helpers::is_reversible<Seq1>::value && helpers::is_reversible<Seq2>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_multipass<Seq1>::value && helpers::is_multipass<Seq2>::value, void, int>::type is_multipass;
+        typedef typename std::conditional<helpers::is_forward<Seq1>::value && helpers::is_forward<Seq2>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_sized<Seq1>::value && helpers::is_sized<Seq2>::value, void, int>::type is_sized;
+
+        const value_type * last()
+        {
+            inLeft = false;
+            auto result = seq2.last();
+            if(result) return result;
+            inLeft = true;
+            return seq1.last();
+        }
+
+        const value_type * prev()
+        {
+            if(!inLeft)
+            {
+                auto result = seq2.prev();
+                if(result) return result;
+                inLeft = true;
+                return seq1.last();
+            }
+            return seq1.prev();
+        }
+
         // Override for a more efficient implementation
         std::size_t size() const { return seq1.size() + seq2.size(); }
     };
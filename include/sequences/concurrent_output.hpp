@@ -0,0 +1,328 @@
+// Implements an output sequence that can be written to from many threads.
+
+namespace sequences
+{
+    // An output sequence that allows several threads to add elements concurrently,
+    // and forwards them to another output sequence from a single drain thread.
+    //
+    // Each thread adds elements to its own batch, without locking. Full batches are
+    // handed to the drain thread through a lock-free queue, and are written to the
+    // target using add_range().
+    //
+    // In unordered mode, elements from each thread stay in order, but elements from
+    // different threads are interleaved a batch at a time. In ordered mode, each element
+    // takes a ticket when it is added, and the drain writes elements in ticket order.
+    // Elements are held by the drain until all earlier elements have been handed off.
+    //
+    // Partially filled batches are written by flush() and by the destructor, which must
+    // only be called once all threads have finished adding elements.
+    // The target must outlive the concurrent_output.
+    template<typename T>
+    class concurrent_output : public output_sequence<T>
+    {
+    public:
+        concurrent_output(const output_sequence<T> & target, bool ordered = false, std::size_t batch_size = 1024) :
+            target(target), ordered(ordered), batch_size(batch_size ? batch_size : 1),
+            id(++next_id()), producers(nullptr), pending(nullptr), submitted(0), tickets(0),
+            drained(0), stopping(false), failed(false), drain_thread([this] { drain(); })
+        {
+        }
+
+        concurrent_output(const concurrent_output&) = delete;
+        concurrent_output & operator=(const concurrent_output&) = delete;
+
+        ~concurrent_output()
+        {
+            try { flush(); } catch(...) {}
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_one();
+            drain_thread.join();
+
+            for(producer * p = producers.load(); p;)
+            {
+                producer * next = p->next;
+                batch::destroy(p->current);
+                delete p;
+                p = next;
+            }
+        }
+
+        void add(const T & item) const override
+        {
+            producer * p = get_producer();
+            new(get_batch(p)->items + p->current->size) T(item);
+            complete_add(p);
+        }
+
+        void add_moved(T && item) const override
+        {
+            producer * p = get_producer();
+            new(get_batch(p)->items + p->current->size) T(std::move(item));
+            complete_add(p);
+        }
+
+        // Writes all elements added so far to the target, and waits for them to be written.
+        // Rethrows any exception thrown by the target.
+        // Must not be called concurrently with add().
+        void flush() const
+        {
+            for(producer * p = producers.load(std::memory_order_acquire); p; p=p->next)
+            {
+                if(p->current && p->current->size)
+                {
+                    submit(p->current);
+                    p->current = nullptr;
+                }
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return drained == submitted.load(); });
+            if(error)
+            {
+                auto e = error;
+                error = nullptr;
+                std::rethrow_exception(e);
+            }
+        }
+
+    private:
+        // A block of elements added by one thread
+        struct batch
+        {
+            batch * next;
+            std::size_t size, position;
+            T * items;
+            std::uint64_t * tickets;
+
+            static std::size_t align(std::size_t n, std::size_t a) { return (n + a - 1) / a * a; }
+
+            static batch * create(std::size_t capacity, bool ordered)
+            {
+                std::size_t items_offset = align(sizeof(batch), alignof(T));
+                std::size_t tickets_offset = align(items_offset + capacity*sizeof(T), alignof(std::uint64_t));
+                std::size_t bytes = ordered ? tickets_offset + capacity*sizeof(std::uint64_t) : tickets_offset;
+
+                char * memory = static_cast<char*>(::operator new(bytes));
+                batch * b = new(memory) batch;
+                b->next = nullptr;
+                b->size = b->position = 0;
+                b->items = reinterpret_cast<T*>(memory + items_offset);
+                b->tickets = ordered ? reinterpret_cast<std::uint64_t*>(memory + tickets_offset) : nullptr;
+                return b;
+            }
+
+            static void destroy(batch * b)
+            {
+                if(!b) return;
+                for(std::size_t i=0; i<b->size; ++i)
+                    b->items[i].~T();
+                ::operator delete(b);
+            }
+        };
+
+        // The state of each thread that has added elements
+        struct producer
+        {
+            producer * next;
+            std::thread::id thread;
+            batch * current;
+        };
+
+        const output_sequence<T> & target;
+        const bool ordered;
+        const std::size_t batch_size;
+        const std::uint64_t id;
+
+        // Lock-free list of producers, and lock-free stack of full batches
+        mutable std::atomic<producer*> producers;
+        mutable std::atomic<batch*> pending;
+        mutable std::atomic<std::size_t> submitted;
+        mutable std::atomic<std::uint64_t> tickets;
+
+        // Only used to wake and wait for the drain thread
+        mutable std::mutex mutex;
+        mutable std::condition_variable ready, done;
+        mutable std::size_t drained;
+        mutable std::exception_ptr error;
+        bool stopping;
+
+        // Only used by the drain thread
+        bool failed;
+
+        std::thread drain_thread;
+
+        // Identifies instances, so that thread-local caches are not confused by reused addresses
+        static std::atomic<std::uint64_t> & next_id()
+        {
+            static std::atomic<std::uint64_t> value(0);
+            return value;
+        }
+
+        // Finds the producer for the current thread, creating it if necessary
+        producer * get_producer() const
+        {
+            struct cache_entry { std::uint64_t owner; producer * p; };
+            static thread_local cache_entry cache = { 0, nullptr };
+            if(cache.owner == id) return cache.p;
+
+            auto thread = std::this_thread::get_id();
+            producer * p = producers.load(std::memory_order_acquire);
+            while(p && p->thread != thread)
+                p = p->next;
+
+            if(!p)
+            {
+                p = new producer{ producers.load(std::memory_order_relaxed), thread, nullptr };
+                while(!producers.compare_exchange_weak(p->next, p, std::memory_order_release, std::memory_order_relaxed))
+                    ;
+            }
+
+            cache.owner = id;
+            cache.p = p;
+            return p;
+        }
+
+        batch * get_batch(producer * p) const
+        {
+            if(!p->current) p->current = batch::create(batch_size, ordered);
+            return p->current;
+        }
+
+        // Takes a ticket once the element has been constructed, and submits full batches
+        void complete_add(producer * p) const
+        {
+            batch * b = p->current;
+            if(ordered) b->tickets[b->size] = tickets.fetch_add(1, std::memory_order_relaxed);
+            if(++b->size == batch_size)
+            {
+                p->current = nullptr;
+                submit(b);
+            }
+        }
+
+        // Hands a batch to the drain thread
+        void submit(batch * b) const
+        {
+            submitted.fetch_add(1);
+            b->next = pending.load(std::memory_order_relaxed);
+            while(!pending.compare_exchange_weak(b->next, b, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            { std::lock_guard<std::mutex> lock(mutex); }
+            ready.notify_one();
+        }
+
+        void drain()
+        {
+            // Batches waiting for earlier tickets, in ordered mode
+            batch * waiting = nullptr;
+            std::uint64_t next_ticket = 0;
+
+            for(;;)
+            {
+                bool stop;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this] { return pending.load() || stopping; });
+                    stop = stopping;
+                }
+
+                batch * list = pending.exchange(nullptr, std::memory_order_acquire);
+                if(!list && stop) break;
+
+                // The stack is newest first
+                batch * batches = nullptr;
+                std::size_t count = 0;
+                while(list)
+                {
+                    batch * next = list->next;
+                    list->next = batches;
+                    batches = list;
+                    list = next;
+                    ++count;
+                }
+
+                if(ordered)
+                {
+                    while(batches)
+                    {
+                        batch * next = batches->next;
+                        batches->next = waiting;
+                        waiting = batches;
+                        batches = next;
+                    }
+                    write_ordered(waiting, next_ticket);
+                }
+                else
+                {
+                    while(batches)
+                    {
+                        batch * next = batches->next;
+                        write(batches->items, batches->items + batches->size);
+                        batch::destroy(batches);
+                        batches = next;
+                    }
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    drained += count;
+                }
+                done.notify_all();
+            }
+
+            while(waiting)
+            {
+                batch * next = waiting->next;
+                batch::destroy(waiting);
+                waiting = next;
+            }
+        }
+
+        // Writes runs of consecutive tickets until the next ticket has not arrived yet
+        void write_ordered(batch *& waiting, std::uint64_t & next_ticket)
+        {
+            for(;;)
+            {
+                batch ** found = &waiting;
+                while(*found && (*found)->tickets[(*found)->position] != next_ticket)
+                    found = &(*found)->next;
+                if(!*found) return;
+
+                batch * b = *found;
+                std::size_t start = b->position;
+                while(b->position < b->size && b->tickets[b->position] == next_ticket)
+                {
+                    ++b->position;
+                    ++next_ticket;
+                }
+                write(b->items + start, b->items + b->position);
+
+                if(b->position == b->size)
+                {
+                    *found = b->next;
+                    batch::destroy(b);
+                }
+            }
+        }
+
+        void write(const T * begin, const T * end)
+        {
+            // Elements are discarded after the target has failed
+            if(failed) return;
+            try
+            {
+                target.add_range(begin, end);
+            }
+            catch(...)
+            {
+                failed = true;
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+            }
+        }
+    };
+}
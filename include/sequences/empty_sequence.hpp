@@ -9,6 +9,12 @@ namespace sequences
         typedef T value_type;
         const value_type * first() { return nullptr; }
         const value_type * next() { return nullptr; }
+        typedef void is_reversible;
+        typedef void is_multipass;
+        typedef void is_forward;
+        typedef void is_sized;
+        const value_type * last() { return nullptr; }
+        const value_type * prev() { return nullptr; }
         std::size_t size() const { return 0; }
     };
 }
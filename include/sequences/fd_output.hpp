@@ -0,0 +1,360 @@
+// Implements output sequences that write to POSIX file descriptors.
+// Only available if SEQUENCE_ENABLE_POSIX is defined.
+
+namespace sequences
+{
+    // Writes bytes to a file descriptor through a large buffer.
+    // Writes that do not fit in the buffer are sent together with the buffer in a single writev().
+    // The capacity is at least min_capacity bytes, so that formatted numbers can be reserved in place.
+    class fd_buffer
+    {
+    public:
+        static constexpr std::size_t min_capacity = 64;
+
+        explicit fd_buffer(int fd, std::size_t capacity = 1<<16) :
+            fd(fd), owned(false), length(0), capacity(clamp(capacity)), buffer(clamp(capacity)) {}
+
+        // Creates or truncates the file at the given path
+        explicit fd_buffer(const char * path, std::size_t capacity = 1<<16) :
+            fd(::open(path, O_WRONLY|O_CREAT|O_TRUNC, 0666)), owned(true), length(0), capacity(clamp(capacity)), buffer(clamp(capacity))
+        {
+            if(fd<0) throw std::runtime_error("Could not open file for writing");
+        }
+
+        fd_buffer(fd_buffer && other) :
+            fd(other.fd), owned(other.owned), length(other.length), capacity(other.capacity), buffer(std::move(other.buffer))
+        {
+            other.fd = -1;
+            other.owned = false;
+            other.length = 0;
+        }
+
+        fd_buffer(const fd_buffer&) = delete;
+        fd_buffer & operator=(const fd_buffer&) = delete;
+
+        ~fd_buffer()
+        {
+            try { flush(); } catch(...) {}
+            if(owned) ::close(fd);
+        }
+
+        void write(const void * data, std::size_t size)
+        {
+            if(size <= capacity - length)
+            {
+                std::memcpy(buffer.get()+length, data, size);
+                length += size;
+            }
+            else
+                write_large(data, size);
+        }
+
+        // Returns space for at least size bytes (which must not exceed the capacity, or min_capacity).
+        // Call commit() with the number of bytes actually used.
+        char * reserve(std::size_t size)
+        {
+            if(size > capacity - length) flush();
+            return buffer.get()+length;
+        }
+
+        void commit(std::size_t size) { length += size; }
+
+        // Writes all buffered data to the file descriptor
+        void flush()
+        {
+            if(length)
+            {
+                iovec iov[1] = { { buffer.get(), length } };
+                length = 0;
+                write_all(iov, 1);
+            }
+        }
+
+    private:
+        int fd;
+        bool owned;
+        std::size_t length, capacity;
+        detail::byte_buffer buffer;
+
+        static std::size_t clamp(std::size_t capacity) { return capacity < min_capacity ? min_capacity : capacity; }
+
+        void write_large(const void * data, std::size_t size)
+        {
+            if(size < capacity)
+            {
+                flush();
+                std::memcpy(buffer.get(), data, size);
+                length = size;
+            }
+            else
+            {
+                // Write the buffer and the data in one system call
+                iovec iov[2] = { { buffer.get(), length }, { const_cast<void*>(data), size } };
+                length = 0;
+                write_all(iov, 2);
+            }
+        }
+
+        void write_all(iovec * iov, int count)
+        {
+            while(count)
+            {
+                ssize_t written = ::writev(fd, iov, count);
+                if(written < 0)
+                {
+                    if(errno == EINTR) continue;
+                    throw std::runtime_error("Failed to write to file");
+                }
+
+                // Skip over what was written
+                for(; count && (std::size_t)written >= iov->iov_len; ++iov, --count)
+                    written -= iov->iov_len;
+                if(count)
+                {
+                    iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                    iov->iov_len -= written;
+                }
+            }
+        }
+    };
+
+    constexpr std::size_t fd_buffer::min_capacity;
+
+    namespace detail
+    {
+        // Formats an unsigned integer, writing backwards from end.
+        // Returns the start of the formatted number.
+        inline char * format_unsigned(char * end, std::uint64_t value)
+        {
+            static const char digits[] =
+                "0001020304050607080910111213141516171819"
+                "2021222324252627282930313233343536373839"
+                "4041424344454647484950515253545556575859"
+                "6061626364656667686970717273747576777879"
+                "8081828384858687888990919293949596979899";
+
+            while(value >= 100)
+            {
+                auto i = (value % 100) * 2;
+                value /= 100;
+                *--end = digits[i+1];
+                *--end = digits[i];
+            }
+            if(value >= 10)
+            {
+                *--end = digits[value*2+1];
+                *--end = digits[value*2];
+            }
+            else
+                *--end = char('0' + value);
+            return end;
+        }
+
+#if !defined(__cpp_lib_to_chars)
+        inline int print_float(char * buffer, std::size_t size, int precision, double value)
+        {
+            return std::snprintf(buffer, size, "%.*g", precision, value);
+        }
+
+        inline int print_float(char * buffer, std::size_t size, int precision, long double value)
+        {
+            return std::snprintf(buffer, size, "%.*Lg", precision, value);
+        }
+#endif
+
+        // Formats a floating point number using the shortest representation
+        // that reads back as the same value, and always uses '.' as the decimal point.
+        template<typename T>
+        std::size_t format_float(char * buffer, std::size_t size, T value)
+        {
+#if defined(__cpp_lib_to_chars)
+            return std::to_chars(buffer, buffer+size, value).ptr - buffer;
+#else
+            typedef typename std::conditional<std::is_same<T, long double>::value, long double, double>::type wide;
+            int n = print_float(buffer, size, std::numeric_limits<T>::digits10, wide(value));
+            if(value == value && T(std::strtold(buffer, nullptr)) != value)
+                n = print_float(buffer, size, std::numeric_limits<T>::max_digits10, wide(value));
+            for(int i=0; i<n; ++i)
+                if(buffer[i]==',') buffer[i]='.';
+            return n;
+#endif
+        }
+    }
+
+    // Defines how elements are written as text by fd_output.
+    // Specialize this class to write other types.
+    template<typename T, typename = void>
+    struct text_format
+    {
+        static_assert(sizeof(T)==0, "Specialize sequences::text_format<T> to write this type as text");
+    };
+
+    template<typename T>
+    struct text_format<T, typename std::enable_if<std::is_integral<T>::value && sizeof(T)!=1 && !std::is_same<T,bool>::value>::type>
+    {
+        static const bool separated = true;
+
+        static void write(fd_buffer & out, T value)
+        {
+            char * end = out.reserve(24) + 24;
+            char * start = value < 0 ?
+                detail::format_unsigned(end, 0 - (std::uint64_t)value) :
+                detail::format_unsigned(end, (std::uint64_t)value);
+            if(value < 0) *--start = '-';
+            std::memmove(end-24, start, end-start);
+            out.commit(end-start);
+        }
+    };
+
+    // Characters and bools are written as single characters
+    template<typename T>
+    struct text_format<T, typename std::enable_if<std::is_integral<T>::value && sizeof(T)==1>::type>
+    {
+        static const bool separated = true;
+
+        static void write(fd_buffer & out, T value)
+        {
+            char ch = std::is_same<T,bool>::value ? (value ? '1' : '0') : (char)value;
+            out.write(&ch, 1);
+        }
+    };
+
+    template<typename T>
+    struct text_format<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+    {
+        static const bool separated = true;
+
+        static void write(fd_buffer & out, T value)
+        {
+            out.commit(detail::format_float(out.reserve(64), 64, value));
+        }
+    };
+
+    template<typename Traits, typename Alloc>
+    struct text_format<std::basic_string<char, Traits, Alloc>>
+    {
+        static const bool separated = true;
+
+        static void write(fd_buffer & out, const std::basic_string<char, Traits, Alloc> & str)
+        {
+            out.write(str.data(), str.size());
+        }
+    };
+
+    template<typename Ch>
+    struct text_format<Ch*, typename std::enable_if<std::is_same<typename std::remove_const<Ch>::type, char>::value>::type>
+    {
+        static const bool separated = true;
+
+        static void write(fd_buffer & out, const char * str)
+        {
+            out.write(str, std::strlen(str));
+        }
+    };
+
+    // Writes elements as raw bytes, without separators
+    template<typename T>
+    struct binary_format
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "binary_format requires trivially copyable elements");
+
+        static const bool separated = false;
+
+        static void write(fd_buffer & out, const T & item)
+        {
+            out.write(&item, sizeof(T));
+        }
+
+        static void write_range(fd_buffer & out, const T * begin, const T * end)
+        {
+            out.write(begin, (end-begin)*sizeof(T));
+        }
+    };
+
+    // An output sequence that writes elements to a file descriptor.
+    // Format defines how each element is written, for example text_format<T> or binary_format<T>.
+    // In text format, each element is followed by a separator.
+    // Data is buffered, and is written when the buffer is full or when the output is destroyed.
+    template<typename T, typename Format = text_format<T>>
+    class fd_output : public output_sequence<T>
+    {
+    public:
+        fd_output(int fd, const char * separator = "\n", std::size_t capacity = 1<<16) :
+            buffer(fd, capacity), separator(separator ? separator : "") {}
+
+        fd_output(const char * path, const char * separator = "\n", std::size_t capacity = 1<<16) :
+            buffer(path, capacity), separator(separator ? separator : "") {}
+
+        fd_output(fd_output && other) :
+            buffer(std::move(other.buffer)), separator(std::move(other.separator)) {}
+
+        void add(const T & item) const override
+        {
+            put(item);
+        }
+
+        void add_range(const T * begin, const T * end) const override
+        {
+            put_range(begin, end, std::integral_constant<bool, !Format::separated>());
+        }
+
+        // Stream the contents of a sequence without virtual calls
+        template<typename Seq, typename = typename Seq::is_sequence>
+        const fd_output & operator<<(const Seq & seq) const
+        {
+            write(seq, std::integral_constant<int,
+                helpers::is_contiguous<Seq>::value && std::is_same<typename Seq::value_type, T>::value ? 1 :
+                helpers::is_chunked<Seq, T>::value ? 2 : 0>());
+            return *this;
+        }
+
+        const fd_output & operator<<(const T & item) const
+        {
+            put(item);
+            return *this;
+        }
+
+        // Writes any buffered data
+        void flush() const { buffer.flush(); }
+
+    private:
+        mutable fd_buffer buffer;
+        std::string separator;
+
+        void put(const T & item) const
+        {
+            Format::write(buffer, item);
+            if(Format::separated && !separator.empty())
+                buffer.write(separator.data(), separator.size());
+        }
+
+        void put_range(const T * begin, const T * end, std::true_type) const
+        {
+            Format::write_range(buffer, begin, end);
+        }
+
+        void put_range(const T * begin, const T * end, std::false_type) const
+        {
+            for(; begin!=end; ++begin) put(*begin);
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,1>) const
+        {
+            add_range(seq.data(), seq.data()+seq.size());
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,2>) const
+        {
+            for(auto & chunk : seq)
+                add_range(chunk.data(), chunk.data()+chunk.size());
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,0>) const
+        {
+            for(auto &i: seq) put(i);
+        }
+    };
+}
@@ -0,0 +1,295 @@
+// Implements sequences that read files on a background thread, so that reading overlaps with processing.
+// Only available if SEQUENCE_ENABLE_POSIX is defined.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // A file descriptor shared by copies of a file source, which is closed if it was opened by the source
+        struct file_descriptor
+        {
+            int fd;
+            bool owned;
+
+            file_descriptor(int fd, bool owned) : fd(fd), owned(owned) {}
+            file_descriptor(const file_descriptor&) = delete;
+            file_descriptor & operator=(const file_descriptor&) = delete;
+            ~file_descriptor() { if(owned) ::close(fd); }
+        };
+
+        // Reads a file from the start into a ring of buffers on a background thread.
+        // The consumer holds one buffer while the thread fills the others.
+        // Files that cannot be seeked, such as pipes, are read using read(), and the thread
+        // waits for them using poll(), so that it can be stopped while no data is available.
+        class read_ahead
+        {
+        public:
+            read_ahead(int fd, std::size_t buffer_size, std::size_t buffer_count, bool hints) :
+                fd(fd), buffer_size(buffer_size), buffer_count(buffer_count), hints(hints),
+                storage(buffer_size * buffer_count), lengths(new std::size_t[buffer_count]),
+                produced(0), released(0), holding(false), finished(false), stopping(false), error(0)
+            {
+                if(::pipe(wake) != 0) throw std::runtime_error("Could not create a pipe for file_reader()");
+                thread = std::thread([this] { run(); });
+            }
+
+            read_ahead(const read_ahead&) = delete;
+            read_ahead & operator=(const read_ahead&) = delete;
+
+            ~read_ahead()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopping = true;
+                }
+                changed.notify_all();
+
+                // Interrupts the thread if it is waiting for a pipe or terminal
+                char byte = 0;
+                while(::write(wake[1], &byte, 1) < 0 && errno == EINTR)
+                    ;
+                thread.join();
+                ::close(wake[0]);
+                ::close(wake[1]);
+            }
+
+            // Releases the buffer held by the consumer, and waits for the next buffer to be filled.
+            // Returns false at the end of the file.
+            bool next(const char *& data, std::size_t & size)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if(holding)
+                {
+                    ++released;
+                    holding = false;
+                    changed.notify_all();
+                }
+                changed.wait(lock, [this] { return produced > released || finished; });
+                if(produced == released)
+                {
+                    if(error) throw std::runtime_error("Could not read file");
+                    return false;
+                }
+                std::size_t slot = released % buffer_count;
+                data = storage.get() + slot * buffer_size;
+                size = lengths[slot];
+                holding = true;
+                return true;
+            }
+
+        private:
+            int fd;
+            std::size_t buffer_size, buffer_count;
+            bool hints;
+            byte_buffer storage;
+            std::unique_ptr<std::size_t[]> lengths;
+
+            // The number of buffers filled by the thread, and released by the consumer
+            std::uint64_t produced, released;
+            bool holding, finished, stopping;
+            int error;
+            std::mutex mutex;
+            std::condition_variable changed;
+            std::thread thread;
+
+            // A pipe that is written to when stopping
+            int wake[2];
+
+            // Waits until the file can be read. Returns false if the reader is stopping.
+            bool wait_readable() const
+            {
+                pollfd fds[2] = { { fd, POLLIN, 0 }, { wake[0], POLLIN, 0 } };
+                while(::poll(fds, 2, -1) < 0)
+                    if(errno != EINTR) return true;  // Let read() report the error
+                return !fds[1].revents;
+            }
+
+            void run()
+            {
+                std::uint64_t offset = 0;
+                bool seekable = true;
+#ifdef POSIX_FADV_SEQUENTIAL
+                if(hints)
+                {
+                    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                    ::posix_fadvise(fd, 0, buffer_size * buffer_count, POSIX_FADV_WILLNEED);
+                }
+#endif
+                for(;;)
+                {
+                    std::size_t slot;
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        changed.wait(lock, [this] { return stopping || produced - released < buffer_count; });
+                        if(stopping) return;
+                        slot = produced % buffer_count;
+                    }
+
+#ifdef POSIX_FADV_WILLNEED
+                    // Asks the kernel to read the buffer after the ones that are already requested
+                    if(hints && seekable)
+                        ::posix_fadvise(fd, offset + buffer_size * buffer_count, buffer_size, POSIX_FADV_WILLNEED);
+#endif
+
+                    // Fills the buffer, unless the end of the file is reached.
+                    // Data from pipes and terminals is passed on as soon as it is read.
+                    char * buffer = storage.get() + slot * buffer_size;
+                    std::size_t length = 0;
+                    int read_error = 0;
+                    bool end = false;
+                    while(length < buffer_size)
+                    {
+                        if(!seekable && !wait_readable()) return;
+                        ssize_t n = seekable ? ::pread(fd, buffer + length, buffer_size - length, offset + length) : ::read(fd, buffer + length, buffer_size - length);
+                        if(n > 0)
+                        {
+                            length += n;
+                            if(!seekable) break;
+                        }
+                        else if(n == 0)
+                        {
+                            end = true;
+                            break;
+                        }
+                        else if(errno == ESPIPE && seekable && offset + length == 0)
+                            seekable = false;  // Pipes are read once using read()
+                        else if(errno != EINTR)
+                        {
+                            read_error = errno;
+                            break;
+                        }
+                    }
+                    offset += length;
+
+                    bool done = end || read_error;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        lengths[slot] = length;
+                        if(length) ++produced;
+                        error = read_error;
+                        finished = done;
+                    }
+                    changed.notify_all();
+                    if(done) return;
+                }
+            }
+        };
+    }
+
+    // The contents of a file as a sequence of contiguous chunks, which are read on a background thread.
+    // Each chunk is a pointer_sequence<char> that is valid until the next chunk is requested.
+    // Each iteration reads the file from the start, and copies of the sequence have their own thread.
+    class file_chunks : public base_sequence<pointer_sequence<char>, file_chunks>
+    {
+    public:
+        typedef pointer_sequence<char> value_type;
+        typedef void is_chunked;
+
+        file_chunks(int fd, bool owned, std::size_t buffer_size, std::size_t buffer_count, bool hints) :
+            file(std::make_shared<detail::file_descriptor>(fd, owned)), buffer_size(buffer_size),
+            buffer_count(buffer_count < 2 ? 2 : buffer_count), hints(hints), current(nullptr, nullptr)
+        {
+            if(buffer_size == 0) throw std::invalid_argument("file_reader() buffer size must be positive");
+        }
+
+        // Copies do not share the reader thread
+        file_chunks(const file_chunks & other) : file(other.file), buffer_size(other.buffer_size),
+            buffer_count(other.buffer_count), hints(other.hints), current(nullptr, nullptr) {}
+
+        file_chunks & operator=(const file_chunks&) = delete;
+
+        const value_type * first()
+        {
+            reader.reset();
+            reader.reset(new detail::read_ahead(file->fd, buffer_size, buffer_count, hints));
+            return next();
+        }
+
+        const value_type * next()
+        {
+            const char * data;
+            std::size_t size;
+            if(reader && reader->next(data, size))
+            {
+                current = value_type(data, data + size);
+                return &current;
+            }
+            reader.reset();
+            return nullptr;
+        }
+
+    private:
+        std::shared_ptr<detail::file_descriptor> file;
+        std::size_t buffer_size, buffer_count;
+        bool hints;
+        std::unique_ptr<detail::read_ahead> reader;
+        value_type current;
+    };
+
+    // The characters of a file, which are read on a background thread while the previous
+    // buffer is being processed. Blocks and chunks() point directly into the buffers.
+    class file_source : public base_sequence<char, file_source>
+    {
+    public:
+        typedef char value_type;
+
+        file_source(int fd, bool owned, std::size_t buffer_size, std::size_t buffer_count, bool hints) :
+            source(fd, owned, buffer_size, buffer_count, hints), position(nullptr), limit(nullptr) {}
+
+        file_source(const file_source & other) : source(other.source), position(nullptr), limit(nullptr) {}
+
+        file_source & operator=(const file_source&) = delete;
+
+        const char * first()
+        {
+            return start(source.first());
+        }
+
+        const char * next()
+        {
+            if(position && ++position != limit) return position;
+            return start(source.next());
+        }
+
+        // The contents of the file as contiguous chunks of up to the buffer size
+        file_chunks chunks() const { return source; }
+
+        typedef void is_blockwise;
+
+        const char * first_block(char *, std::size_t & n)
+        {
+            start(source.first());
+            return take_block(n);
+        }
+
+        const char * next_block(char *, std::size_t & n)
+        {
+            if(position == limit) start(source.next());
+            return take_block(n);
+        }
+
+    private:
+        file_chunks source;
+        const char *position, *limit;
+
+        const char * start(const pointer_sequence<char> * chunk)
+        {
+            if(chunk)
+            {
+                position = chunk->data();
+                limit = position + chunk->size();
+            }
+            else
+                position = limit = nullptr;
+            return position;
+        }
+
+        const char * take_block(std::size_t & n)
+        {
+            if(n > std::size_t(limit - position)) n = limit - position;
+            auto block = position;
+            position += n;
+            return block;
+        }
+    };
+}
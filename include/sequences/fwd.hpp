@@ -41,9 +41,109 @@ namespace sequences
     template<typename Seq>
     class repeat_sequence;
 
-    template<typename Seq>
+    template<typename Seq, typename Alloc>
     class split_sequence;
 
     template<typename Container>
     class stored_sequence;
+
+    template<typename Seq>
+    class reverse_sequence;
+
+    template<typename Seq>
+    class reverse_buffer_sequence;
+
+    template<typename Seq>
+    class cached_sequence;
+
+    template<typename Seq>
+    class spill_sequence;
+
+    template<typename Seq, typename Fn>
+    class select_many_sequence;
+
+    template<typename Seq, typename Fn>
+    class select_many_output_sequence;
+
+    template<typename... Seqs>
+    class zip_sequence;
+
+    template<typename Seq, typename Less>
+    class merge_sorted_sequence;
+
+    enum class set_operation { union_of, intersection, difference, symmetric_difference };
+
+    template<typename Seq1, typename Seq2, typename Less, set_operation Op>
+    class set_sequence;
+
+    template<typename Seq>
+    class window_sequence;
+
+    template<typename Seq>
+    class chunk_sequence;
+
+    template<typename Seq, typename Op>
+    class rolling_sequence;
+
+    namespace detail
+    {
+        template<typename T>
+        class rolling_sum;
+
+        template<typename T>
+        class rolling_mean;
+
+        template<typename T, typename Less>
+        class rolling_extreme;
+    }
+
+    template<typename T, typename Fn>
+    class function_inserter;
+
+    namespace detail
+    {
+        template<typename Container>
+        struct appender;
+    }
+
+    template<typename T, bool Raw = std::is_trivially_copyable<T>::value>
+    class record_file;
+
+    class profiler;
+
+    template<typename Seq>
+    class probe_sequence;
+
+    template<typename Seq, typename Address>
+    class prefetch_sequence;
+
+    template<typename Seq, typename T>
+    class gather_sequence;
+
+    namespace detail
+    {
+        template<bool Stable>
+        struct element_address;
+    }
+
+    template<typename T>
+    class contiguous_range;
+
+    template<typename Int>
+    class counting_range;
+
+    template<typename Seq>
+    class forward_range;
+
+    template<typename Hash, typename T>
+    class hash_output;
+
+    template<typename T, typename = void>
+    struct key_hash;
+
+    namespace detail
+    {
+        template<typename T, typename Hash>
+        struct hash_pair;
+    }
 }
@@ -12,6 +12,8 @@ namespace sequences
 
         generated_sequence(First f, Next n) : firstFn(f), nextFn(n) {}
 
+        typedef void is_forward;
+
         value_type result;
 
         const value_type * first()
@@ -0,0 +1,376 @@
+// Implements streaming hashes and checksums of bytes, and outputs that compute them from sequences.
+// Each hash implements update(data, size) to add bytes, and value() to get the result so far.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // Little-endian loads, which compile to a single load on little-endian targets
+        inline std::uint32_t load32(const unsigned char * p)
+        {
+            return std::uint32_t(p[0]) | std::uint32_t(p[1])<<8 | std::uint32_t(p[2])<<16 | std::uint32_t(p[3])<<24;
+        }
+
+        inline std::uint64_t load64(const unsigned char * p)
+        {
+            return std::uint64_t(load32(p)) | std::uint64_t(load32(p+4))<<32;
+        }
+
+        inline std::uint64_t rotl64(std::uint64_t x, int r)
+        {
+            return x<<r | x>>(64-r);
+        }
+
+        // Mixes the bits of a 64-bit value, so that every input bit affects every output bit
+        inline std::uint64_t mix64(std::uint64_t x)
+        {
+            x ^= x>>33;
+            x *= 0xff51afd7ed558ccdull;
+            x ^= x>>33;
+            x *= 0xc4ceb9fe1a85ec53ull;
+            return x ^ x>>33;
+        }
+
+        // The tables for computing CRC32C 8 bytes at a time (slicing-by-8)
+        struct crc32c_tables
+        {
+            std::uint32_t table[8][256];
+
+            crc32c_tables()
+            {
+                for(std::uint32_t n=0; n<256; ++n)
+                {
+                    std::uint32_t crc = n;
+                    for(int k=0; k<8; ++k)
+                        crc = crc&1 ? 0x82F63B78u ^ (crc>>1) : crc>>1;
+                    table[0][n] = crc;
+                }
+                for(int k=1; k<8; ++k)
+                    for(int n=0; n<256; ++n)
+                        table[k][n] = table[k-1][n]>>8 ^ table[0][table[k-1][n] & 0xff];
+            }
+
+            static const crc32c_tables & get()
+            {
+                static const crc32c_tables tables;
+                return tables;
+            }
+        };
+
+        inline std::uint32_t crc32c_scalar(std::uint32_t crc, const unsigned char * p, std::size_t size)
+        {
+            auto & t = crc32c_tables::get().table;
+            for(; size >= 8; size -= 8, p += 8)
+            {
+                std::uint32_t lo = crc ^ load32(p), hi = load32(p+4);
+                crc = t[7][lo & 0xff] ^ t[6][lo>>8 & 0xff] ^ t[5][lo>>16 & 0xff] ^ t[4][lo>>24] ^
+                    t[3][hi & 0xff] ^ t[2][hi>>8 & 0xff] ^ t[1][hi>>16 & 0xff] ^ t[0][hi>>24];
+            }
+            for(; size; --size, ++p)
+                crc = t[0][(crc ^ *p) & 0xff] ^ crc>>8;
+            return crc;
+        }
+
+#if defined(__x86_64__) && (defined(__SSE4_2__) || SEQUENCE_CPU_DISPATCH)
+#if !defined(__SSE4_2__)
+        __attribute__((target("sse4.2")))
+#endif
+        inline std::uint32_t crc32c_sse42(std::uint32_t crc, const unsigned char * p, std::size_t size)
+        {
+            std::uint64_t crc64 = crc;
+            for(; size >= 8; size -= 8, p += 8)
+            {
+                std::uint64_t word;
+                std::memcpy(&word, p, 8);
+                crc64 = __builtin_ia32_crc32di(crc64, word);
+            }
+            crc = std::uint32_t(crc64);
+            for(; size; --size, ++p)
+                crc = __builtin_ia32_crc32qi(crc, *p);
+            return crc;
+        }
+#endif
+    }
+
+    // The CRC-32C (Castagnoli) checksum, as used by iSCSI, ext4 and many storage formats.
+    // Uses the SSE4.2 crc32 instruction if available, and slicing-by-8 tables otherwise.
+    class crc32c
+    {
+    public:
+        typedef std::uint32_t result_type;
+
+        crc32c() : crc(~0u) {}
+
+        void update(const void * data, std::size_t size)
+        {
+            auto p = static_cast<const unsigned char*>(data);
+#if defined(__x86_64__) && (defined(__SSE4_2__) || SEQUENCE_CPU_DISPATCH)
+            if(detail::has_sse42())
+            {
+                crc = detail::crc32c_sse42(crc, p, size);
+                return;
+            }
+#endif
+            crc = detail::crc32c_scalar(crc, p, size);
+        }
+
+        result_type value() const { return ~crc; }
+
+    private:
+        std::uint32_t crc;
+    };
+
+    // The 64-bit xxHash (XXH64) of the bytes, with an optional seed.
+    // Bytes are processed in stripes of 32 bytes, and partial stripes are buffered.
+    class xxhash64
+    {
+    public:
+        typedef std::uint64_t result_type;
+
+        explicit xxhash64(std::uint64_t seed = 0) : seed(seed), total(0), buffered(0)
+        {
+            acc[0] = seed + prime1 + prime2;
+            acc[1] = seed + prime2;
+            acc[2] = seed;
+            acc[3] = seed - prime1;
+        }
+
+        void update(const void * data, std::size_t size)
+        {
+            if(!size) return;
+            auto p = static_cast<const unsigned char*>(data), end = p + size;
+            total += size;
+            if(buffered)
+            {
+                std::size_t n = std::min<std::size_t>(32 - buffered, size);
+                std::memcpy(buffer + buffered, p, n);
+                buffered += n;
+                p += n;
+                if(buffered < 32) return;
+                stripe(buffer);
+                buffered = 0;
+            }
+            for(; end-p >= 32; p += 32)
+                stripe(p);
+            std::memcpy(buffer, p, end-p);
+            buffered = end-p;
+        }
+
+        result_type value() const
+        {
+            std::uint64_t h;
+            if(total >= 32)
+            {
+                h = detail::rotl64(acc[0], 1) + detail::rotl64(acc[1], 7) + detail::rotl64(acc[2], 12) + detail::rotl64(acc[3], 18);
+                for(int i=0; i<4; ++i)
+                    h = (h ^ round(0, acc[i])) * prime1 + prime4;
+            }
+            else
+                h = seed + prime5;
+            h += total;
+
+            const unsigned char * p = buffer, * end = buffer + buffered;
+            for(; end-p >= 8; p += 8)
+                h = detail::rotl64(h ^ round(0, detail::load64(p)), 27) * prime1 + prime4;
+            if(end-p >= 4)
+            {
+                h = detail::rotl64(h ^ detail::load32(p) * prime1, 23) * prime2 + prime3;
+                p += 4;
+            }
+            for(; p!=end; ++p)
+                h = detail::rotl64(h ^ *p * prime5, 11) * prime1;
+
+            h ^= h>>33;
+            h *= prime2;
+            h ^= h>>29;
+            h *= prime3;
+            return h ^ h>>32;
+        }
+
+    private:
+        static const std::uint64_t prime1 = 0x9E3779B185EBCA87ull, prime2 = 0xC2B2AE3D27D4EB4Full,
+            prime3 = 0x165667B19E3779F9ull, prime4 = 0x85EBCA77C2B2AE63ull, prime5 = 0x27D4EB2F165667C5ull;
+
+        std::uint64_t seed, total, acc[4];
+        unsigned char buffer[32];
+        std::size_t buffered;
+
+        static std::uint64_t round(std::uint64_t acc, std::uint64_t input)
+        {
+            return detail::rotl64(acc + input * prime2, 31) * prime1;
+        }
+
+        void stripe(const unsigned char * p)
+        {
+            for(int i=0; i<4; ++i)
+                acc[i] = round(acc[i], detail::load64(p + 8*i));
+        }
+    };
+
+    // The FNV-1a hash, which is simple and fast for short keys
+    template<typename UInt, UInt Offset, UInt Prime>
+    class basic_fnv1a
+    {
+    public:
+        typedef UInt result_type;
+
+        basic_fnv1a() : h(Offset) {}
+
+        void update(const void * data, std::size_t size)
+        {
+            auto p = static_cast<const unsigned char*>(data);
+            for(; size; --size, ++p)
+                h = (h ^ *p) * Prime;
+        }
+
+        result_type value() const { return h; }
+
+    private:
+        UInt h;
+    };
+
+    typedef basic_fnv1a<std::uint32_t, 0x811C9DC5u, 0x01000193u> fnv1a32;
+    typedef basic_fnv1a<std::uint64_t, 0xCBF29CE484222325ull, 0x100000001B3ull> fnv1a64;
+
+    // An output sequence that hashes the bytes written to it.
+    // Single bytes are buffered so that they are hashed in bulk.
+    template<typename Hash, typename T>
+    class hash_output : public output_sequence<T>
+    {
+        static_assert(helpers::is_byte<T>::value, "Only sequences of bytes can be hashed");
+    public:
+        typedef typename Hash::result_type result_type;
+
+        hash_output(const Hash & hash = Hash()) : hash(hash), buffered(0), buffer() {}
+
+        void add(const T & item) const override
+        {
+            put(item);
+        }
+
+        void add_range(const T * begin, const T * end) const override
+        {
+            flush();
+            hash.update(begin, end-begin);
+        }
+
+        // Stream the contents of a sequence without virtual calls.
+        // Contiguous sequences, chunks and blocks are hashed in bulk.
+        template<typename Seq, typename = typename Seq::is_sequence>
+        const hash_output & operator<<(const Seq & seq) const
+        {
+            write(seq, std::integral_constant<int,
+                helpers::is_contiguous<Seq>::value && std::is_same<typename Seq::value_type, T>::value ? 1 :
+                helpers::is_chunked<Seq, T>::value ? 2 :
+                helpers::is_blockwise<Seq>::value && std::is_same<typename Seq::value_type, T>::value ? 3 : 0>());
+            return *this;
+        }
+
+        const hash_output & operator<<(const T & item) const
+        {
+            put(item);
+            return *this;
+        }
+
+        // The hash of the bytes written so far
+        result_type value() const
+        {
+            flush();
+            return hash.value();
+        }
+
+    private:
+        mutable Hash hash;
+        mutable std::size_t buffered;
+        mutable unsigned char buffer[256];
+
+        void put(const T & item) const
+        {
+            if(buffered == sizeof(buffer)) flush();
+            buffer[buffered++] = item;
+        }
+
+        void flush() const
+        {
+            if(buffered)
+            {
+                hash.update(buffer, buffered);
+                buffered = 0;
+            }
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,1>) const
+        {
+            add_range(seq.data(), seq.data()+seq.size());
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,2>) const
+        {
+            for(auto & chunk : seq)
+                add_range(chunk.data(), chunk.data()+chunk.size());
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,3>) const
+        {
+            T block_buffer[helpers::block_size];
+            std::size_t n = helpers::block_size;
+            for(auto block = seq.self().first_block(block_buffer, n); n; block = seq.self().next_block(block_buffer, n = helpers::block_size))
+                add_range(block, block+n);
+        }
+
+        template<typename Seq>
+        void write(const Seq & seq, std::integral_constant<int,0>) const
+        {
+            for(auto &i: seq) put(i);
+        }
+    };
+
+    // Hashes keys for hash tables, for example to partition or deduplicate elements.
+    // Strings and other containers of bytes are hashed using xxhash64, and other
+    // keys are hashed using std::hash and then mixed, so that all bits of the hash are useful.
+    template<typename T, typename>
+    struct key_hash
+    {
+        std::uint64_t operator()(const T & key) const
+        {
+            return detail::mix64(std::hash<T>()(key));
+        }
+    };
+
+    template<typename T>
+    struct key_hash<T, typename std::enable_if<helpers::has_data<T>::value &&
+        helpers::is_byte<typename helpers::remove_all<decltype(*std::declval<const T&>().data())>::type>::value>::type>
+    {
+        std::uint64_t operator()(const T & key) const
+        {
+            xxhash64 hash;
+            hash.update(key.data(), key.size());
+            return hash.value();
+        }
+    };
+
+    template<typename Ch>
+    struct key_hash<const Ch*, typename std::enable_if<helpers::is_byte<Ch>::value>::type>
+    {
+        std::uint64_t operator()(const Ch * key) const
+        {
+            xxhash64 hash;
+            hash.update(key, std::char_traits<Ch>::length(key));
+            return hash.value();
+        }
+    };
+
+    namespace detail
+    {
+        // Pairs an element with the hash of its key
+        template<typename T, typename Hash>
+        struct hash_pair
+        {
+            Hash hash;
+            std::pair<std::uint64_t, T> operator()(const T & item) const { return { hash(item), item }; }
+        };
+    }
+}
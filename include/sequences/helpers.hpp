@@ -60,6 +60,353 @@ namespace sequences
             typedef typename remove_all<R>::type type;
         };
 
+        // Detects sequences, which declare `typedef void is_sequence`.
+        template<typename Seq, typename = void>
+        struct is_sequence : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_sequence<Seq, typename Seq::is_sequence> : public std::true_type
+        {
+        };
+
+        // Detects sequences that can skip ahead to a value using seek(value, less).
+        // Such sequences declare `typedef void is_seekable`.
+        template<typename Seq, typename = void>
+        struct is_seekable : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_seekable<Seq, typename Seq::is_seekable> : public std::true_type
+        {
+        };
+
+        // Finds the first element in [first,last) that is not less than value,
+        // searching forwards in exponentially increasing steps.
+        // This takes O(log d) steps, where d is the distance to the element.
+        template<typename It, typename T, typename Less>
+        It gallop(It first, It last, const T & value, Less & less)
+        {
+            if(first==last || !less(*first, value)) return first;
+            typename std::iterator_traits<It>::difference_type step = 1;
+            while(step < last-first && less(first[step], value))
+            {
+                first += step;
+                step *= 2;
+            }
+            return std::lower_bound(first+1, step < last-first ? first+step : last, value, less);
+        }
+
+        // Detects sequences of consecutive, non-overlapping contiguous chunks of T, such as the result of chunk().
+        // Such sequences declare `typedef void is_chunked`, so that sequences of overlapping
+        // contiguous sequences, such as window(), are not treated as chunks.
+        template<typename Seq, typename T, typename = void>
+        struct is_chunked : public std::false_type
+        {
+        };
+
+        template<typename Seq, typename T>
+        struct is_chunked<Seq, T, typename Seq::is_chunked> :
+            public std::is_same<typename Seq::value_type::value_type, T>
+        {
+        };
+
+        // Whether all of the values are true
+        template<bool... Bs>
+        struct all_true : public std::is_same<all_true<true, Bs...>, all_true<Bs..., true>>
+        {
+        };
+
+        // A list of indices, for expanding tuples
+        template<std::size_t... I>
+        struct indices
+        {
+        };
+
+        template<std::size_t N, std::size_t... I>
+        struct make_indices : public make_indices<N-1, N-1, I...>
+        {
+        };
+
+        template<std::size_t... I>
+        struct make_indices<0, I...>
+        {
+            typedef indices<I...> type;
+        };
+
+        // Detects sequences that can be iterated backwards in place, using last() and prev().
+        // Such sequences declare `typedef void is_reversible`.
+        template<typename Seq, typename = void>
+        struct is_reversible : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_reversible<Seq, typename Seq::is_reversible> : public std::true_type
+        {
+        };
+
+        // Detects sequences that can be iterated more than once cheaply, because
+        // they do not read from a stream or call functors on each element.
+        // Such sequences declare `typedef void is_multipass`.
+        template<typename Seq, typename = void>
+        struct is_multipass : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_multipass<Seq, typename Seq::is_multipass> : public std::true_type
+        {
+        };
+
+        // Detects sequences whose copies can be iterated independently of each other,
+        // because they do not share a stream or another sequence. range() gives forward iterators
+        // over such sequences. Such sequences declare `typedef void is_forward`.
+        template<typename Seq, typename = void>
+        struct is_forward : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_forward<Seq, typename Seq::is_forward> : public std::true_type
+        {
+        };
+
+        // Detects sequences whose elements stay at the same address while the sequence exists,
+        // so that pointers to earlier elements are still valid after next().
+        // Such sequences declare `typedef void is_stable`.
+        template<typename Seq, typename = void>
+        struct is_stable : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_stable<Seq, typename Seq::is_stable> : public std::true_type
+        {
+        };
+
+        // Detects sequences whose elements are stored contiguously in memory.
+        // Such sequences declare `typedef void is_contiguous` and implement data() and size().
+        template<typename Seq, typename = void>
+        struct is_contiguous : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_contiguous<Seq, typename Seq::is_contiguous> : public std::true_type
+        {
+        };
+
+        // Detects sequences where size() is O(1).
+        // Such sequences declare `typedef void is_sized`.
+        template<typename Seq, typename = void>
+        struct is_sized : public std::false_type
+        {
+        };
+
+        template<typename Seq>
+        struct is_sized<Seq, typename Seq::is_sized> : public std::true_type
+        {
+        };
+
+        // Detects sequences that can produce their elements in blocks of up to block_size elements,
+        // so that terminal operations can run as tight loops that the compiler can vectorize.
+        // Such sequences declare `typedef void is_blockwise` and implement
+        // `const T * first_block(T * buffer, std::size_t & n)` and next_block(), which return
+        // up to n elements, either in buffer or in their own storage, and set n to the number
+        // of elements returned. n is 0 at the end of the sequence.
+        // Blocks are only used if SEQUENCE_ENABLE_BLOCKS is enabled.
+        template<typename Seq, typename = void>
+        struct is_blockwise : public std::false_type
+        {
+        };
+
+#if SEQUENCE_ENABLE_BLOCKS
+        template<typename Seq>
+        struct is_blockwise<Seq, typename Seq::is_blockwise> : public std::true_type
+        {
+        };
+#endif
+
+        // Detects blockwise sequences that can return their blocks before they are filtered,
+        // together with a selection mask, so that sum() and size() do not need to compact them.
+        // Such sequences declare `typedef void is_masked` and implement
+        // `const T * first_masked_block(T * buffer, mask * mask, std::size_t & n)` and next_masked_block(),
+        // where mask is the detail::lane_mask of T, and a lane is all ones if the element is selected.
+        template<typename Seq, typename = void>
+        struct is_masked : public std::false_type
+        {
+        };
+
+#if SEQUENCE_ENABLE_BLOCKS
+        template<typename Seq>
+        struct is_masked<Seq, typename Seq::is_masked> : public std::true_type
+        {
+        };
+#endif
+
+        // The maximum number of elements in a block
+        static const std::size_t block_size = 64;
+
+        // Whether the caller is being evaluated at compile time, where blocks are not used.
+        // If this cannot be detected, blocks are only used when constexpr is not supported.
+        inline SEQUENCE_CONSTEXPR bool constant_evaluated()
+        {
+#if defined(__cpp_lib_is_constant_evaluated)
+            return std::is_constant_evaluated();
+#elif defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+            return __builtin_is_constant_evaluated();
+#else
+            return __cpp_constexpr >= 201603L;
+#endif
+#else
+            return __cpp_constexpr >= 201603L;
+#endif
+        }
+
+        // Detects containers with a data() member
+        template<typename Container, typename = void>
+        struct has_data : public std::false_type
+        {
+        };
+
+        template<typename Container>
+        struct has_data<Container, decltype((void)std::declval<const Container&>().data())> : public std::true_type
+        {
+        };
+
+        // Detects whether an iterator supports random access
+        template<typename It>
+        struct is_random_access : public std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category>
+        {
+        };
+
+        // Detects the character types that std::basic_string supports.
+        // Other integers have no std::char_traits in some standard libraries.
+        template<typename T>
+        struct is_character : public std::integral_constant<bool,
+            std::is_same<T, char>::value || std::is_same<T, wchar_t>::value ||
+#ifdef __cpp_char8_t
+            std::is_same<T, char8_t>::value ||
+#endif
+            std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value>
+        {
+        };
+
+        // Detects iterators over contiguous memory: pointers, and the iterators of strings
+        // (and vectors if SEQUENCE_ENABLE_VECTOR is defined)
+        template<typename It, typename T, bool Character = is_character<T>::value>
+        struct is_string_iterator : public std::integral_constant<bool,
+            std::is_same<It, typename std::basic_string<T>::const_iterator>::value ||
+            std::is_same<It, typename std::basic_string<T>::iterator>::value>
+        {
+        };
+
+        template<typename It, typename T>
+        struct is_string_iterator<It, T, false> : public std::false_type
+        {
+        };
+
+        template<typename It, typename T = typename std::iterator_traits<It>::value_type>
+        struct is_contiguous_iterator : public std::integral_constant<bool,
+            std::is_pointer<It>::value || is_string_iterator<It, T>::value
+#if SEQUENCE_ENABLE_VECTOR
+            || std::is_same<It, typename std::vector<T>::const_iterator>::value
+            || std::is_same<It, typename std::vector<T>::iterator>::value
+#endif
+            >
+        {
+        };
+
+        // Detects whether copies of an iterator can be incremented independently
+        template<typename It>
+        struct is_forward_iterator : public std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<It>::iterator_category>
+        {
+        };
+
+        // Detects whether an iterator can be decremented
+        template<typename It>
+        struct is_bidirectional : public std::is_base_of<std::bidirectional_iterator_tag, typename std::iterator_traits<It>::iterator_category>
+        {
+        };
+
+        // Detects whether a functor can be called with the given argument
+        template<typename Fn, typename Arg, typename = void>
+        struct is_callable : public std::false_type
+        {
+        };
+
+        template<typename Fn, typename Arg>
+        struct is_callable<Fn, Arg, decltype((void)std::declval<Fn&>()(std::declval<Arg>()))> : public std::true_type
+        {
+        };
+
+        // Deduce the element type U of a functor taking a `const output_sequence<U>&` as its second parameter
+        template<typename Fn>
+        struct deduce_output : public deduce_output<decltype(&Fn::operator())>
+        {
+        };
+
+        template<typename R, typename C, typename T, typename U>
+        struct deduce_output<R(C::*)(T, const output_sequence<U>&) const>
+        {
+            typedef U type;
+        };
+
+        template<typename R, typename T, typename U>
+        struct deduce_output<R(*)(T, const output_sequence<U>&)>
+        {
+            typedef U type;
+        };
+
+        // Describes how to join elements into a string.
+        // Elements can be characters, C strings, or strings with data() and size().
+        template<typename T, typename = void>
+        struct join_traits
+        {
+            typedef typename T::value_type char_type;
+            static std::size_t size(const T & str) { return str.size(); }
+
+            template<typename String>
+            static void append(String & result, const T & str) { result.append(str.data(), str.size()); }
+        };
+
+        template<typename Ch>
+        struct join_traits<Ch, typename std::enable_if<is_character<Ch>::value>::type>
+        {
+            typedef Ch char_type;
+            static std::size_t size(const Ch &) { return 1; }
+
+            template<typename String>
+            static void append(String & result, Ch ch) { result.push_back(ch); }
+        };
+
+        // Numbers are not characters, so select() them to strings first
+        template<typename T>
+        struct join_traits<T, typename std::enable_if<std::is_arithmetic<T>::value && !is_character<T>::value>::type>
+        {
+            static_assert(!std::is_arithmetic<T>::value, "join() requires characters or strings; convert numbers to strings first");
+            typedef char char_type;
+        };
+
+        template<typename Ch>
+        struct join_traits<const Ch*>
+        {
+            typedef Ch char_type;
+            static std::size_t size(const Ch * str) { return std::char_traits<Ch>::length(str); }
+
+            template<typename String>
+            static void append(String & result, const Ch * str) { result.append(str); }
+        };
+
+        template<typename Ch>
+        struct join_traits<Ch*> : public join_traits<const Ch*>
+        {
+        };
+
         // Functor to get the first element of a pair
         template<typename P>
         struct project_first;
@@ -81,5 +428,29 @@ namespace sequences
             typedef typename remove_all<T2>::type type;
             const type &operator()(const std::pair<T1,T2> &p) const { return p.second; }
         };
+
+        // Functor to compare elements with a value
+        template<typename T>
+        struct equal_to_value
+        {
+            T value;
+            bool operator()(const T & item) const { return item == value; }
+        };
+
+        // Functor to test whether elements are contained in a sequence of values
+        template<typename Set>
+        struct member_of
+        {
+            Set set;
+            template<typename T>
+            bool operator()(const T & item) const { return set.contains(item); }
+        };
+
+        // Detects byte-sized integers, which are searched using memchr() and SIMD kernels
+        template<typename T>
+        struct is_byte : public std::integral_constant<bool,
+            std::is_integral<T>::value && sizeof(T)==1 && !std::is_same<T, bool>::value>
+        {
+        };
     }
 }
@@ -1,6 +1,7 @@
 namespace sequences
 {
     // Wraps an int into an iterator, for use in a range.
+    // seq(a, b) returns a range_sequence instead, and this is kept for code that uses int_iterator directly.
     class int_iterator
     {
         int value;
@@ -23,6 +23,45 @@ namespace sequences
             return current!=to ? &*current : nullptr;
         }
 
+        typedef void is_multipass;
+        typedef typename std::conditional<helpers::is_forward_iterator<It>::value, void, int>::type is_forward;
+
+        // Forward iterators refer to elements that stay in the container
+        typedef typename std::conditional<helpers::is_forward_iterator<It>::value, void, int>::type is_stable;
+        typedef typename std::conditional<helpers::is_random_access<It>::value, void, int>::type is_sized;
+
+        // Bidirectional iterators can be reversed in place
+        typedef typename std::conditional<helpers::is_bidirectional<It>::value, void, int>::type is_reversible;
+
+        // Iterators over contiguous memory can be written and chunked without copying
+        typedef typename std::conditional<helpers::is_contiguous_iterator<It>::value, void, int>::type is_contiguous;
+
+        const value_type * data() const { return from==to ? nullptr : &*from; }
+
+        // Random access iterators can skip ahead in O(log n)
+        typedef typename std::conditional<helpers::is_random_access<It>::value, void, int>::type is_seekable;
+
+        // Advances to the first element that is not less than value
+        template<typename Less>
+        const value_type * seek(const value_type & value, Less & less)
+        {
+            current = helpers::gallop(current, to, value, less);
+            return current!=to ? &*current : nullptr;
+        }
+
+        const value_type * last()
+        {
+            current = to;
+            return prev();
+        }
+
+        const value_type * prev()
+        {
+            if(current==from) return nullptr;
+            --current;
+            return &*current;
+        }
+
         std::size_t size() const { return std::distance(from, to); }
     };
 
@@ -38,6 +77,8 @@ namespace sequences
 
         cached_iterator_sequence(It from, It to) : from(from), to(to), current(from) {}
 
+        typedef typename std::conditional<helpers::is_forward_iterator<It>::value, void, int>::type is_forward;
+
         const value_type * first()
         { 
             current = from;
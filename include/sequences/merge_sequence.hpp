@@ -14,6 +14,7 @@ namespace sequences
         merge_sequence(const Seq1 & s1, const Seq2 & s2, Fn fn) : seq1(s1), seq2(s2), fn(fn) {}
 
         typedef typename helpers::deduce_result<Fn>::type value_type;
+        typedef typename std::conditional<helpers::is_forward<Seq1>::value && helpers::is_forward<Seq2>::value, void, int>::type is_forward;
 
         value_type current;
 
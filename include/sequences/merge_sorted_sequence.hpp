@@ -0,0 +1,239 @@
+// Implements a k-way merge of sorted sequences.
+
+namespace sequences
+{
+    // Merges any number of sorted sequences into one sorted sequence.
+    // Seq is a sequence of sequences, which are copied each time the merge starts.
+    //
+    // The merge uses a tournament (loser) tree, so each element costs O(log k) comparisons
+    // for k sequences, and no memory is allocated after the merge has started.
+    // Equal elements are taken from the earlier sequence first.
+    template<typename Seq, typename Less>
+    class merge_sorted_sequence : public base_sequence<typename Seq::value_type::value_type, merge_sorted_sequence<Seq, Less>>
+    {
+    public:
+        typedef typename Seq::value_type source_type;
+        typedef typename source_type::value_type value_type;
+
+        merge_sorted_sequence(const Seq & seq, Less less) : seq(seq), less(less), count(0) {}
+
+        // Copies do not copy the iteration state
+        merge_sorted_sequence(const merge_sorted_sequence & other) : seq(other.seq), less(other.less), count(0) {}
+
+        const value_type * first()
+        {
+            sources.clear();
+            for(auto s = seq.first(); s; s = seq.next())
+                sources.push_back(*s);
+
+            if(sources.size() != count)
+            {
+                count = sources.size();
+                storage.reset(count * (sizeof(source_type*) + sizeof(const value_type*) + sizeof(std::size_t)));
+            }
+            if(!count) return nullptr;
+
+            losers = reinterpret_cast<std::size_t*>(storage.get());
+            heads = reinterpret_cast<const value_type**>(storage.get() + count*sizeof(std::size_t));
+            items = reinterpret_cast<source_type**>(storage.get() + count*(sizeof(std::size_t) + sizeof(const value_type*)));
+
+            std::size_t i = 0;
+            for(auto c = sources.first_chunk(); c; c = c->next)
+                for(std::size_t j=0; j<c->size; ++j, ++i)
+                {
+                    items[i] = c->items + j;
+                    heads[i] = items[i]->first();
+                }
+
+            losers[0] = build(1);
+            return heads[losers[0]];
+        }
+
+        const value_type * next()
+        {
+            std::size_t winner = losers[0];
+            heads[winner] = items[winner]->next();
+
+            // Replay the matches from the leaf to the root
+            for(std::size_t node = (winner + count) / 2; node; node /= 2)
+            {
+                if(beats(losers[node], winner))
+                    std::swap(losers[node], winner);
+            }
+            losers[0] = winner;
+            return heads[winner];
+        }
+
+    private:
+        Seq seq;
+        Less less;
+
+        // The sequences being merged
+        chunked_buffer<source_type> sources;
+        std::size_t count;
+
+        // losers[0] is the overall winner, losers[n] is the loser at internal node n
+        detail::byte_buffer storage;
+        std::size_t * losers;
+        const value_type ** heads;
+        source_type ** items;
+
+        // Whether the head of sequence a should come before the head of sequence b
+        bool beats(std::size_t a, std::size_t b) const
+        {
+            if(!heads[a]) return false;
+            if(!heads[b]) return true;
+            if(less(*heads[a], *heads[b])) return true;
+            return a < b && !less(*heads[b], *heads[a]);
+        }
+
+        // Plays the matches below the given node, and returns the winner.
+        // Leaves are numbered from count to 2*count-1.
+        std::size_t build(std::size_t node)
+        {
+            if(node >= count) return node - count;
+            std::size_t left = build(2*node), right = build(2*node+1);
+            if(beats(right, left)) std::swap(left, right);
+            losers[node] = right;
+            return left;
+        }
+    };
+
+    namespace detail
+    {
+        // A sequence of sequence_ref<T>, referring to copies of sequences of different types
+        template<typename T, typename... Seqs>
+        class sequence_tuple : public base_sequence<sequence_ref<T>, sequence_tuple<T, Seqs...>>
+        {
+        public:
+            typedef sequence_ref<T> value_type;
+
+            sequence_tuple(const Seqs&... seqs) : seqs(seqs...), refs(make_refs(typename helpers::make_indices<sizeof...(Seqs)>::type())) {}
+
+            sequence_tuple(const sequence_tuple & other) : seqs(other.seqs), refs(make_refs(typename helpers::make_indices<sizeof...(Seqs)>::type())) {}
+
+            const value_type * first()
+            {
+                current = refs.data();
+                return current;
+            }
+
+            const value_type * next()
+            {
+                return ++current == refs.data() + refs.size() ? nullptr : current;
+            }
+
+        private:
+            std::tuple<virtual_sequence<T, Seqs>...> seqs;
+            std::array<value_type, sizeof...(Seqs)> refs;
+            const value_type * current;
+
+            template<std::size_t... I>
+            std::array<value_type, sizeof...(Seqs)> make_refs(helpers::indices<I...>)
+            {
+                return {{ value_type(std::get<I>(seqs))... }};
+            }
+        };
+
+        // The sequence_tuple for the first N arguments
+        template<typename T, std::size_t N, typename... Args>
+        struct sources_tuple;
+
+        template<typename T>
+        struct sources_tuple<T, 0>
+        {
+            typedef sequence_tuple<T> type;
+        };
+
+        template<typename T, typename Less>
+        struct sources_tuple<T, 0, Less>
+        {
+            typedef sequence_tuple<T> type;
+        };
+
+        template<typename T, std::size_t N, typename Arg, typename... Args>
+        struct sources_tuple<T, N, Arg, Args...>
+        {
+            template<typename Tuple, typename S>
+            struct prepend;
+
+            template<typename... Seqs, typename S>
+            struct prepend<sequence_tuple<T, Seqs...>, S>
+            {
+                typedef sequence_tuple<T, S, Seqs...> type;
+            };
+
+            typedef typename prepend<typename sources_tuple<T, N-1, Args...>::type, typename Arg::stored_type>::type type;
+        };
+
+        // Works out the arguments to merge_sorted(seqs..., less)
+        template<typename... Args>
+        struct merge_sorted_args
+        {
+            typedef typename std::tuple_element<sizeof...(Args)-1, std::tuple<Args...>>::type last_type;
+            typedef typename std::tuple_element<0, std::tuple<Args...>>::type first_type;
+
+            static const bool has_less = !helpers::is_sequence<last_type>::value;
+            static const std::size_t size = sizeof...(Args) - has_less;
+
+            typedef typename first_type::value_type value_type;
+            typedef typename std::conditional<has_less, last_type, std::less<value_type>>::type less_type;
+
+            // Whether Arg is the comparator, or a sequence that is stored as the first sequence
+            template<typename Arg, typename = void>
+            struct is_same_type : public std::true_type
+            {
+            };
+
+            template<typename Arg>
+            struct is_same_type<Arg, typename Arg::is_sequence> : public std::is_same<typename Arg::stored_type, typename first_type::stored_type>
+            {
+            };
+
+            // Sequences of the same type are stored in an array,
+            // otherwise they are stored in a tuple and accessed using virtual functions.
+            static const bool same_type = helpers::all_true<is_same_type<Args>::value...>::value;
+            typedef typename std::conditional<same_type, typename first_type::stored_type, sequence_ref<value_type>>::type source_type;
+            typedef typename std::conditional<same_type,
+                stored_sequence<std::array<source_type, size>>,
+                typename sources_tuple<value_type, size, Args...>::type>::type sources_type;
+            typedef merge_sorted_sequence<sources_type, less_type> result_type;
+
+            static result_type make(const Args&... args)
+            {
+                return make(std::forward_as_tuple(args...), typename helpers::make_indices<size>::type(), std::integral_constant<bool, has_less>());
+            }
+
+        private:
+            template<typename Tuple, std::size_t... I>
+            static result_type make(const Tuple & args, helpers::indices<I...>, std::true_type)
+            {
+                return { sources(args, helpers::indices<I...>()), std::get<size>(args) };
+            }
+
+            template<typename Tuple, std::size_t... I>
+            static result_type make(const Tuple & args, helpers::indices<I...>, std::false_type)
+            {
+                return { sources(args, helpers::indices<I...>()), less_type() };
+            }
+
+            template<typename Tuple, std::size_t... I>
+            static sources_type sources(const Tuple & args, helpers::indices<I...>)
+            {
+                return sources(args, helpers::indices<I...>(), std::integral_constant<bool, same_type>());
+            }
+
+            template<typename Tuple, std::size_t... I>
+            static sources_type sources(const Tuple & args, helpers::indices<I...>, std::true_type)
+            {
+                return { std::array<source_type, size>{{ source_type(std::get<I>(args).self())... }} };
+            }
+
+            template<typename Tuple, std::size_t... I>
+            static sources_type sources(const Tuple & args, helpers::indices<I...>, std::false_type)
+            {
+                return { std::get<I>(args).self()... };
+            }
+        };
+    }
+}
@@ -11,11 +11,32 @@ public:
     // Add an element to the sequence
     virtual void add(const T & item) const =0;
 
-    // Stream the contents of a sequence to the output
+    // Add an element that can be moved from.
+    // This is not virtual, so that subclasses that only override add(const T&) do not hide it.
+    void add(T && item) const { add_moved(std::move(item)); }
+
+    // Add an element that can be moved from.
+    // Override this to avoid copying the element.
+    virtual void add_moved(T && item) const { add(static_cast<const T&>(item)); }
+
+    // Add a contiguous range of elements.
+    // Override this to add elements in bulk.
+    virtual void add_range(const T * begin, const T * end) const
+    {
+        for(; begin!=end; ++begin) add(*begin);
+    }
+
+    // Indicates that count more elements are about to be added
+    virtual void reserve(std::size_t) const {}
+
+    // Stream the contents of a sequence to the output.
+    // Contiguous sequences, and each chunk of a chunked sequence, are added in bulk using add_range().
     template<typename Seq, typename = typename Seq::is_sequence>
     const output_sequence<T> & operator<<(const Seq & seq) const
     {
-        for(auto &i: seq) add(i);
+        write(seq, std::integral_constant<int,
+            sequences::helpers::is_contiguous<Seq>::value && std::is_same<typename Seq::value_type, T>::value ? 1 :
+            sequences::helpers::is_chunked<Seq, T>::value ? 2 : 0>());
         return *this;
     }
 
@@ -26,13 +47,83 @@ public:
         return *this;
     }
 
+    // Add an element that can be moved from (alternative)
+    const output_sequence<T> & operator<<(T && item) const
+    {
+        add(std::move(item));
+        return *this;
+    }
+
     // Helper to identify this type as an output sequence
     typedef void is_output_sequence;
+
+private:
+    template<typename Seq>
+    void write(const Seq & seq, std::integral_constant<int,1>) const
+    {
+        add_range(seq.data(), seq.data()+seq.size());
+    }
+
+    template<typename Seq>
+    void write(const Seq & seq, std::integral_constant<int,2>) const
+    {
+        for(auto & chunk : seq)
+            add_range(chunk.data(), chunk.data()+chunk.size());
+    }
+
+    template<typename Seq>
+    void write(const Seq & seq, std::integral_constant<int,0>) const
+    {
+        if(sequences::helpers::is_sized<Seq>::value) reserve(seq.size());
+        for(auto &i: seq) add(i);
+    }
 };
 
 namespace sequences
 {
+    namespace detail
+    {
+        // Calls fn.add_range() if it exists, otherwise calls fn on each element
+        template<typename Fn, typename T>
+        auto add_range(const Fn & fn, const T * begin, const T * end, int) -> decltype(fn.add_range(begin, end))
+        {
+            return fn.add_range(begin, end);
+        }
+
+        template<typename Fn, typename T>
+        void add_range(const Fn & fn, const T * begin, const T * end, long)
+        {
+            for(; begin!=end; ++begin) fn(*begin);
+        }
+
+        // Calls fn.reserve() if it exists
+        template<typename Fn>
+        auto reserve(const Fn & fn, std::size_t count, int) -> decltype(fn.reserve(count))
+        {
+            return fn.reserve(count);
+        }
+
+        template<typename Fn>
+        void reserve(const Fn &, std::size_t, long)
+        {
+        }
+
+        // Calls fn with an rvalue if possible
+        template<typename Fn, typename T>
+        auto move_to(const Fn & fn, T && item, int) -> decltype(fn(std::move(item)))
+        {
+            return fn(std::move(item));
+        }
+
+        template<typename Fn, typename T>
+        void move_to(const Fn & fn, const T & item, long)
+        {
+            fn(item);
+        }
+    }
+
     // An output sequence that calls the given functor for each element added.
+    // If the functor has add_range() or reserve() members, these are used as well.
     template<typename T, typename Fn>
     class function_inserter : public output_sequence<T>
     {
@@ -41,22 +132,95 @@ namespace sequences
         function_inserter(Fn fn) : fn(fn) {}
 
         void add(const T & item) const override
-        { 
+        {
             fn(item);
         }
+
+        void add_moved(T && item) const override
+        {
+            detail::move_to(fn, std::move(item), 0);
+        }
+
+        void add_range(const T * begin, const T * end) const override
+        {
+            detail::add_range(fn, begin, end, 0);
+        }
+
+        void reserve(std::size_t count) const override
+        {
+            detail::reserve(fn, count, 0);
+        }
     };
 
     namespace detail
     {
+        // Reserves space in containers that support it
+        template<typename Container>
+        auto reserve_container(Container & c, std::size_t count, int) -> decltype(c.reserve(count))
+        {
+            return c.reserve(count);
+        }
+
+        template<typename Container>
+        void reserve_container(Container &, std::size_t, long)
+        {
+        }
+
+        // Inserts at the end of a container.
+        // Associative containers use emplace_hint(), which is O(1) for sorted input.
+        template<typename Container, typename T>
+        auto insert_at_end(Container & c, T && item, int) -> decltype((void)c.emplace_hint(c.end(), std::forward<T>(item)))
+        {
+            c.emplace_hint(c.end(), std::forward<T>(item));
+        }
+
+        template<typename Container, typename T>
+        void insert_at_end(Container & c, T && item, long)
+        {
+            c.insert(c.end(), std::forward<T>(item));
+        }
+
+        // Inserts a range at the end of a container.
+        template<typename Container, typename T>
+        auto insert_range(Container & c, const T * begin, const T * end, int) -> decltype((void)c.emplace_hint(c.end(), *begin))
+        {
+            for(auto hint = c.end(); begin!=end; ++begin)
+                hint = std::next(c.emplace_hint(hint, *begin));
+        }
+
+        template<typename Container, typename T>
+        void insert_range(Container & c, const T * begin, const T * end, long)
+        {
+            c.insert(c.end(), begin, end);
+        }
+
         // Functor to append elements to a given container
         template<typename Container>
         struct appender
         {
             Container & c;
 
-            void operator()(const typename Container::value_type & item) const
+            typedef typename Container::value_type value_type;
+
+            void operator()(const value_type & item) const
+            {
+                insert_at_end(c, item, 0);
+            }
+
+            void operator()(value_type && item) const
+            {
+                insert_at_end(c, std::move(item), 0);
+            }
+
+            // insert() grows the container geometrically, so this does not reserve space
+            void add_range(const value_type * begin, const value_type * end) const
+            {
+                insert_range(c, begin, end, 0);
+            }
+
+            void reserve(std::size_t count) const
             {
-                c.insert(c.end(), item);
+                reserve_container(c, c.size()+count, 0);
             }
         };
     }
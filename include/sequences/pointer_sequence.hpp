@@ -6,7 +6,7 @@ class pointer_sequence : public sequences::base_sequence<T, pointer_sequence<T>>
 {
     const T *a, *b, *current;
 public:
-    pointer_sequence(const T * a, const T *b) : a(a), b(b) {}
+    SEQUENCE_CONSTEXPR pointer_sequence(const T * a, const T *b) : a(a), b(b), current(a) {}
 
     pointer_sequence(const sequences::empty_sequence<T>&) : a(nullptr), b(nullptr) {}
 
@@ -15,16 +15,61 @@ public:
     template<typename Container>
     pointer_sequence(const sequences::stored_sequence<Container> & seq) : a(seq.container.data()), b(seq.container.data()+seq.container.size()) {}
 
-    const T * first()
+    SEQUENCE_CONSTEXPR const T * first()
     { 
         current = a;
         return current==b ? nullptr : current;
     }
 
-    const T * next()
+    SEQUENCE_CONSTEXPR const T * next()
     {
         return ++current==b ? nullptr : current;
     }
 
-    std::size_t size() const { return b-a; }
+    typedef void is_reversible;
+    typedef void is_multipass;
+    typedef void is_forward;
+    typedef void is_contiguous;
+    typedef void is_stable;
+    typedef void is_sized;
+    typedef void is_seekable;
+    typedef typename std::conditional<std::is_arithmetic<T>::value, void, int>::type is_blockwise;
+
+    SEQUENCE_CONSTEXPR const T * data() const { return a; }
+
+    // Blocks point into the original data
+    const T * first_block(T *, std::size_t & n)
+    {
+        current = a;
+        return next_block(nullptr, n);
+    }
+
+    const T * next_block(T *, std::size_t & n)
+    {
+        if(n > std::size_t(b-current)) n = b-current;
+        auto block = current;
+        current += n;
+        return block;
+    }
+
+    // Advances to the first element that is not less than value
+    template<typename Less>
+    const T * seek(const T & value, Less & less)
+    {
+        current = sequences::helpers::gallop(current, b, value, less);
+        return current==b ? nullptr : current;
+    }
+
+    SEQUENCE_CONSTEXPR const T * last()
+    {
+        current = b;
+        return current==a ? nullptr : --current;
+    }
+
+    SEQUENCE_CONSTEXPR const T * prev()
+    {
+        return current==a ? nullptr : --current;
+    }
+
+    SEQUENCE_CONSTEXPR std::size_t size() const { return b-a; }
 };
@@ -0,0 +1,156 @@
+// Implements stages that read ahead of the consumer and prefetch memory that will be accessed,
+// so that cache misses on indirect data overlap instead of stalling on each element.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // Hints that memory will be read soon. This does nothing on compilers without a prefetch builtin.
+        inline void prefetch(const void * address)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_prefetch(address);
+#else
+            (void)address;
+#endif
+        }
+
+        // The address prefetched for an element by prefetch(): elements that are pointers prefetch
+        // what they point to. Other elements prefetch themselves if they stay in place (Stable),
+        // such as the nodes of a std::map or std::list, and nothing otherwise.
+        template<bool Stable>
+        struct element_address
+        {
+            template<typename T>
+            const void * operator()(T * const & p) const { return p; }
+
+            template<typename T>
+            const void * operator()(const T & item) const { return Stable ? &item : nullptr; }
+        };
+    }
+
+    // Reads up to distance elements ahead of the underlying sequence, and prefetches
+    // address(element) of each element as it is read.
+    // Sources whose elements stay in place are read ahead by pointer, and the elements of
+    // other sources are copied into a ring buffer.
+    template<typename Seq, typename Address>
+    class prefetch_sequence : public base_sequence<typename Seq::value_type, prefetch_sequence<Seq, Address>>
+    {
+    public:
+        typedef typename Seq::value_type value_type;
+
+    private:
+        static const bool stable = helpers::is_stable<Seq>::value;
+        typedef typename std::conditional<stable, const value_type*, value_type>::type slot_type;
+
+        Seq seq;
+        Address address;
+        detail::ring_buffer<slot_type> ahead;
+        bool done;
+
+    public:
+        prefetch_sequence(const Seq & seq, std::size_t distance, Address address) :
+            seq(seq), address(address), ahead(distance ? distance : 1), done(true) {}
+
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+
+        const value_type * first()
+        {
+            ahead.clear();
+            const value_type * p;
+            for(p = seq.first(); p; p = seq.next())
+            {
+                read(p);
+                if(ahead.full()) break;
+            }
+            done = !p;
+            return current();
+        }
+
+        const value_type * next()
+        {
+            if(ahead.empty()) return nullptr;
+            ahead.pop_front();
+            if(!done)
+            {
+                if(auto p = seq.next())
+                    read(p);
+                else
+                    done = true;
+            }
+            return current();
+        }
+
+    private:
+        void read(const value_type * item)
+        {
+            store(item, std::integral_constant<bool, stable>());
+            if(const void * p = address(*item))
+                detail::prefetch(p);
+        }
+
+        void store(const value_type * item, std::true_type) { ahead.append(item); }
+        void store(const value_type * item, std::false_type) { ahead.append(*item); }
+
+        const value_type * current() const
+        {
+            return ahead.empty() ? nullptr : element(ahead.front(), std::integral_constant<bool, stable>());
+        }
+
+        static const value_type * element(const value_type * item, std::true_type) { return item; }
+        static const value_type * element(const value_type & item, std::false_type) { return &item; }
+    };
+
+    // Yields base[i] for each index i in a sequence of indices, prefetching
+    // the elements up to distance indices ahead of the consumer.
+    template<typename Seq, typename T>
+    class gather_sequence : public base_sequence<T, gather_sequence<Seq, T>>
+    {
+        Seq indices;
+        const T * base;
+        detail::ring_buffer<const T*> ahead;
+        bool done;
+    public:
+        typedef T value_type;
+
+        gather_sequence(const Seq & indices, const T * base, std::size_t distance) :
+            indices(indices), base(base), ahead(distance ? distance : 1), done(true) {}
+
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+
+        const T * first()
+        {
+            ahead.clear();
+            const typename Seq::value_type * i;
+            for(i = indices.first(); i; i = indices.next())
+            {
+                read(*i);
+                if(ahead.full()) break;
+            }
+            done = !i;
+            return ahead.empty() ? nullptr : ahead.front();
+        }
+
+        const T * next()
+        {
+            if(ahead.empty()) return nullptr;
+            ahead.pop_front();
+            if(!done)
+            {
+                if(auto i = indices.next())
+                    read(*i);
+                else
+                    done = true;
+            }
+            return ahead.empty() ? nullptr : ahead.front();
+        }
+
+    private:
+        void read(typename Seq::value_type index)
+        {
+            const T * p = base + index;
+            ahead.append(p);
+            detail::prefetch(p);
+        }
+    };
+}
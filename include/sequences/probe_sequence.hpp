@@ -0,0 +1,90 @@
+// Implements probe(), which measures the elements and time of the pipeline upstream of it.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // The probe that is currently pulling elements on this thread
+        inline probe_stats *& active_probe()
+        {
+            static thread_local probe_stats * probe = nullptr;
+            return probe;
+        }
+
+        // Makes a probe active on this thread, and restores the previous probe
+        // when destroyed, including if the underlying sequence throws
+        class active_probe_scope
+        {
+        public:
+            explicit active_probe_scope(probe_stats * stats) : previous(active_probe()) { active_probe() = stats; }
+            active_probe_scope(const active_probe_scope&) = delete;
+            active_probe_scope & operator=(const active_probe_scope&) = delete;
+            ~active_probe_scope() { active_probe() = previous; }
+
+            probe_stats * const previous;
+        };
+    }
+
+    // Counts the elements from the underlying sequence, and the time spent producing them.
+    // Measurements are accumulated locally, and added to the profiler at the end of each iteration.
+    template<typename Seq>
+    class probe_sequence : public base_sequence<typename Seq::value_type, probe_sequence<Seq>>
+    {
+    public:
+        typedef typename Seq::value_type value_type;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+
+        probe_sequence(const Seq & seq, probe_stats & stats) : seq(seq), stats(&stats), elements(0), ticks(0) {}
+
+        // Copies do not copy the measurements, so that they are only reported once
+        probe_sequence(const probe_sequence & other) : seq(other.seq), stats(other.stats), elements(0), ticks(0) {}
+
+        ~probe_sequence() { flush(); }
+
+        const value_type * first()
+        {
+            flush();
+            stats->iterations.fetch_add(1, std::memory_order_relaxed);
+            return pull(true);
+        }
+
+        const value_type * next()
+        {
+            return pull(false);
+        }
+
+    private:
+        Seq seq;
+        probe_stats * stats;
+        std::uint64_t elements, ticks;
+
+        const value_type * pull(bool restart)
+        {
+            const value_type * result;
+            {
+                // A probe that calls this one is downstream of it
+                detail::active_probe_scope scope(stats);
+                auto downstream = scope.previous;
+                if(downstream && !downstream->input.load(std::memory_order_relaxed))
+                    downstream->input.store(stats, std::memory_order_relaxed);
+
+                auto start = detail::ticks();
+                result = restart ? seq.first() : seq.next();
+                ticks += detail::ticks() - start;
+            }
+
+            if(result)
+                ++elements;
+            else
+                flush();
+            return result;
+        }
+
+        void flush()
+        {
+            if(elements) stats->elements.fetch_add(elements, std::memory_order_relaxed);
+            if(ticks) stats->ticks.fetch_add(ticks, std::memory_order_relaxed);
+            elements = ticks = 0;
+        }
+    };
+}
@@ -0,0 +1,209 @@
+// Implements the profiler that collects measurements from probe() stages.
+// Probes are only compiled if SEQUENCE_ENABLE_PROFILING is enabled, otherwise probe() does nothing.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // A fast timestamp, in cycles on x86 and in nanoseconds otherwise
+        inline std::uint64_t ticks()
+        {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            return __builtin_ia32_rdtsc();
+#else
+            return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+
+        // The number of ticks per second, measured once
+        inline double ticks_per_second()
+        {
+            static const double result = []
+            {
+                auto start = std::chrono::steady_clock::now();
+                auto start_ticks = ticks();
+                while(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(10))
+                    ;
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                return double(ticks() - start_ticks) / seconds;
+            }();
+            return result;
+        }
+    }
+
+    // The measurements of a named probe() stage
+    struct probe_stats
+    {
+        explicit probe_stats(const std::string & name) : name(name), elements(0), iterations(0), ticks(0), input(nullptr) {}
+
+        const std::string name;
+
+        // The number of elements that passed the probe
+        std::atomic<std::uint64_t> elements;
+
+        // The number of times the pipeline was iterated
+        std::atomic<std::uint64_t> iterations;
+
+        // The time spent in the pipeline upstream of the probe
+        std::atomic<std::uint64_t> ticks;
+
+        // The nearest probe upstream of this one, whose elements are the input of the stages between them
+        std::atomic<probe_stats*> input;
+
+        // The next stage in the profiler
+        std::unique_ptr<probe_stats> next;
+    };
+
+    // Collects the measurements of probe() stages, and reports them as a table or JSON.
+    // Probes use profiler::current() by default, which is a global profiler unless a
+    // profiler::scope is active on the current thread.
+    class profiler
+    {
+    public:
+        profiler() : last(nullptr) {}
+        profiler(const profiler&) = delete;
+        profiler & operator=(const profiler&) = delete;
+
+        // Gets the measurements of the named stage, creating it if needed
+        probe_stats & stage(const char * name)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto s = first.get(); s; s = s->next.get())
+                if(s->name == name) return *s;
+            auto & link = last ? last->next : first;
+            link.reset(new probe_stats(name));
+            last = link.get();
+            return *last;
+        }
+
+        // Clears all measurements. Stages stay registered, because probes refer to them.
+        void reset()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(auto s = first.get(); s; s = s->next.get())
+            {
+                s->elements = 0;
+                s->iterations = 0;
+                s->ticks = 0;
+            }
+        }
+
+        // Formats the measurements as a table, with one row per stage
+        std::string table() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string result;
+            char line[256];
+            std::snprintf(line, sizeof(line), "%-20s %14s %14s %11s %12s %12s %10s\n", "stage", "in", "out", "selectivity", "time (ms)", "self (ms)", "iterations");
+            result += line;
+            for(auto s = first.get(); s; s = s->next.get())
+            {
+                row r(*s);
+                char in[32] = "-", selectivity[32] = "-";
+                if(r.input)
+                {
+                    std::snprintf(in, sizeof(in), "%llu", (unsigned long long)r.in);
+                    if(r.in) std::snprintf(selectivity, sizeof(selectivity), "%.4f", double(r.out) / r.in);
+                }
+                std::snprintf(line, sizeof(line), "%-20s %14s %14llu %11s %12.3f %12.3f %10llu\n",
+                    s->name.c_str(), in, (unsigned long long)r.out, selectivity, r.seconds * 1e3, r.self_seconds * 1e3, (unsigned long long)r.iterations);
+                result += line;
+            }
+            return result;
+        }
+
+        // Formats the measurements as a JSON array, with one object per stage
+        std::string json() const
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::string result = "[";
+            char numbers[256];
+            for(auto s = first.get(); s; s = s->next.get())
+            {
+                row r(*s);
+                if(result.size() > 1) result += ",";
+                result += "\n  {\"stage\": \"";
+                for(char ch : s->name)
+                {
+                    if(ch=='"' || ch=='\\') result += '\\';
+                    result += ch;
+                }
+                result += "\", \"in\": ";
+                if(r.input)
+                {
+                    std::snprintf(numbers, sizeof(numbers), "%llu, \"selectivity\": ", (unsigned long long)r.in);
+                    result += numbers;
+                    if(r.in)
+                    {
+                        std::snprintf(numbers, sizeof(numbers), "%.6g", double(r.out) / r.in);
+                        result += numbers;
+                    }
+                    else
+                        result += "null";
+                }
+                else
+                    result += "null, \"selectivity\": null";
+                std::snprintf(numbers, sizeof(numbers), ", \"out\": %llu, \"seconds\": %.9f, \"self_seconds\": %.9f, \"iterations\": %llu}",
+                    (unsigned long long)r.out, r.seconds, r.self_seconds, (unsigned long long)r.iterations);
+                result += numbers;
+            }
+            result += "\n]\n";
+            return result;
+        }
+
+        // The global profiler
+        static profiler & global()
+        {
+            static profiler instance;
+            return instance;
+        }
+
+        // The profiler used by probes created on this thread
+        static profiler & current()
+        {
+            auto p = scoped();
+            return p ? *p : global();
+        }
+
+        // Makes a profiler current on this thread, while the scope exists
+        class scope
+        {
+        public:
+            explicit scope(profiler & p) : previous(scoped()) { scoped() = &p; }
+            ~scope() { scoped() = previous; }
+            scope(const scope&) = delete;
+            scope & operator=(const scope&) = delete;
+        private:
+            profiler * previous;
+        };
+
+    private:
+        mutable std::mutex mutex;
+        std::unique_ptr<probe_stats> first;
+        probe_stats * last;
+
+        static profiler *& scoped()
+        {
+            static thread_local profiler * p = nullptr;
+            return p;
+        }
+
+        // The measurements of a stage, in seconds
+        struct row
+        {
+            explicit row(const probe_stats & s) :
+                input(s.input.load(std::memory_order_relaxed)),
+                in(input ? input->elements.load(std::memory_order_relaxed) : 0),
+                out(s.elements.load(std::memory_order_relaxed)),
+                iterations(s.iterations.load(std::memory_order_relaxed)),
+                seconds(s.ticks.load(std::memory_order_relaxed) / detail::ticks_per_second()),
+                self_seconds(input ? std::max(0.0, seconds - input->ticks.load(std::memory_order_relaxed) / detail::ticks_per_second()) : seconds)
+            {
+            }
+
+            const probe_stats * input;
+            std::uint64_t in, out, iterations;
+            double seconds, self_seconds;
+        };
+    };
+}
@@ -0,0 +1,350 @@
+// Implements integer ranges with a step, and closed-form operations on them.
+
+namespace sequences
+{
+    // A predicate that is true for integers congruent to remainder modulo divisor.
+    // range_sequence::count() computes the count of such integers in closed form.
+    template<typename Int>
+    struct modulo
+    {
+        Int divisor, remainder;
+
+        SEQUENCE_CONSTEXPR modulo(Int divisor, Int remainder = 0) : divisor(divisor), remainder(remainder)
+        {
+            if(!(divisor > 0)) throw std::invalid_argument("modulo divisor must be positive");
+            this->remainder = reduce(remainder);
+        }
+
+        SEQUENCE_CONSTEXPR bool operator()(Int x) const { return reduce(x) == remainder; }
+
+    private:
+        // The non-negative remainder of x
+        SEQUENCE_CONSTEXPR Int reduce(Int x) const
+        {
+            Int r = x % divisor;
+            return r < 0 ? Int(r + divisor) : r;
+        }
+    };
+
+    namespace detail
+    {
+        // Modular arithmetic on 64-bit values that does not overflow
+        inline SEQUENCE_CONSTEXPR std::uint64_t add_mod(std::uint64_t a, std::uint64_t b, std::uint64_t m)
+        {
+            return a >= m - b ? a - (m - b) : a + b;
+        }
+
+        inline SEQUENCE_CONSTEXPR std::uint64_t sub_mod(std::uint64_t a, std::uint64_t b, std::uint64_t m)
+        {
+            return a >= b ? a - b : a + (m - b);
+        }
+
+        inline SEQUENCE_CONSTEXPR std::uint64_t mul_mod(std::uint64_t a, std::uint64_t b, std::uint64_t m)
+        {
+            std::uint64_t result = 0;
+            for(a %= m; b; b >>= 1)
+            {
+                if(b & 1) result = add_mod(result, a, m);
+                a = add_mod(a, a, m);
+            }
+            return result;
+        }
+
+        inline SEQUENCE_CONSTEXPR std::uint64_t gcd(std::uint64_t a, std::uint64_t b)
+        {
+            while(b)
+            {
+                std::uint64_t r = a % b;
+                a = b;
+                b = r;
+            }
+            return a;
+        }
+
+        // The inverse of a modulo m, where a and m are coprime and m > 1
+        inline SEQUENCE_CONSTEXPR std::uint64_t inverse_mod(std::uint64_t a, std::uint64_t m)
+        {
+            std::uint64_t r0 = m, r1 = a, t0 = 0, t1 = 1;
+            while(r1)
+            {
+                std::uint64_t q = r0 / r1, r = r0 - q*r1, t = sub_mod(t0, mul_mod(q, t1, m), m);
+                r0 = r1; r1 = r;
+                t0 = t1; t1 = t;
+            }
+            return t0;
+        }
+
+        // The non-negative remainder of x modulo m
+        template<typename Int>
+        SEQUENCE_CONSTEXPR std::uint64_t residue(Int x, std::uint64_t m, std::true_type)
+        {
+            if(x >= 0) return std::uint64_t(x) % m;
+            std::uint64_t r = (0 - std::uint64_t(x)) % m;
+            return r ? m - r : 0;
+        }
+
+        template<typename Int>
+        SEQUENCE_CONSTEXPR std::uint64_t residue(Int x, std::uint64_t m, std::false_type)
+        {
+            return std::uint64_t(x) % m;
+        }
+
+        template<typename Int>
+        SEQUENCE_CONSTEXPR std::uint64_t residue(Int x, std::uint64_t m)
+        {
+            return residue(x, m, std::is_signed<Int>());
+        }
+
+        // The value type of seq(a, b), which is the promoted common type of A and B.
+        // The type is signed if either A or B is signed, so that seq(-1, 5u) is -1 to 5 rather than empty.
+        template<typename A, typename B, typename Common = decltype(A() + B())>
+        struct range_type
+        {
+            typedef typename std::conditional<std::is_signed<A>::value || std::is_signed<B>::value,
+                typename std::make_signed<Common>::type, Common>::type type;
+        };
+
+        // A count of elements, where negative counts are 0
+        template<typename Count>
+        SEQUENCE_CONSTEXPR std::uint64_t element_count(Count n)
+        {
+            return n > 0 ? std::uint64_t(n) : 0;
+        }
+    }
+
+    // A sequence of integers start, start+step, start+2*step, ...
+    // The size, elements, sum, take() and skip() are computed in closed form.
+    // Arithmetic wraps around in the same way as iterating the range would.
+    template<typename Int>
+    class range_sequence : public base_sequence<Int, range_sequence<Int>>
+    {
+        static_assert(std::is_integral<Int>::value && !std::is_same<Int, bool>::value && sizeof(Int) <= 8,
+            "range_sequence requires an integer type of at most 64 bits");
+    public:
+        typedef Int value_type;
+        typedef typename std::make_signed<Int>::type step_type;
+        typedef std::size_t size_type;
+
+        // The length of an unbounded range
+        static constexpr std::uint64_t unbounded = ~std::uint64_t(0);
+
+        // Constructs the range from `from` to `to` inclusive.
+        // The range is empty if `to` cannot be reached from `from` in the direction of step.
+        SEQUENCE_CONSTEXPR range_sequence(Int from, Int to, step_type step = 1) : start(from), step(step), length(0), index(0), current(from)
+        {
+            if(step==0) throw std::invalid_argument("Range step must not be zero");
+            std::uint64_t distance = 0, stride = 1;
+            if(step > 0)
+            {
+                if(to < from) return;
+                distance = wide(to) - wide(from);
+                stride = wide(step);
+            }
+            else
+            {
+                if(from < to) return;
+                distance = wide(from) - wide(to);
+                stride = 0 - wide(step);
+            }
+            // Ranges over all 2^64 values are treated as unbounded
+            length = distance / stride;
+            if(length != unbounded) ++length;
+        }
+
+        // Constructs the range of length elements, starting at start
+        static SEQUENCE_CONSTEXPR range_sequence with_length(Int start, std::uint64_t length, step_type step = 1)
+        {
+            range_sequence result(start, start, step);
+            result.length = length;
+            return result;
+        }
+
+        typedef void is_reversible;
+        typedef void is_multipass;
+        typedef void is_forward;
+        typedef void is_sized;
+        typedef void is_blockwise;
+
+        SEQUENCE_CONSTEXPR const Int * first()
+        {
+            index = 0;
+            current = start;
+            return length ? &current : nullptr;
+        }
+
+        SEQUENCE_CONSTEXPR const Int * next()
+        {
+            if(++index >= length) return nullptr;
+            current = Int(wide(current) + wide(step));
+            return &current;
+        }
+
+        SEQUENCE_CONSTEXPR const Int * last()
+        {
+            if(!length) return nullptr;
+            index = length-1;
+            current = element(index);
+            return &current;
+        }
+
+        SEQUENCE_CONSTEXPR const Int * prev()
+        {
+            if(index==0) return nullptr;
+            --index;
+            current = Int(wide(current) - wide(step));
+            return &current;
+        }
+
+        const Int * first_block(Int * buffer, std::size_t & n)
+        {
+            index = 0;
+            return next_block(buffer, n);
+        }
+
+        // Computes each element from its index, which the compiler can vectorize
+        const Int * next_block(Int * buffer, std::size_t & n)
+        {
+            // Small types are computed in unsigned int, to avoid promotion to signed int
+            typedef typename std::conditional<(sizeof(Int) < sizeof(unsigned)), unsigned, typename std::make_unsigned<Int>::type>::type lane;
+            if(n > length - index) n = std::size_t(length - index);
+            lane base = lane(element(index)), stride = lane(step);
+            detail::for_each_lane(n, [&](std::size_t i) { buffer[i] = Int(base + lane(i)*stride); });
+            index += n;
+            return buffer;
+        }
+
+        // The number of elements. Unbounded ranges return the maximum size.
+        SEQUENCE_CONSTEXPR size_type size() const
+        {
+            return length > std::numeric_limits<size_type>::max() ? std::numeric_limits<size_type>::max() : size_type(length);
+        }
+
+        SEQUENCE_CONSTEXPR Int at(std::uint64_t index) const
+        {
+            if(index >= length) throw std::out_of_range("at() is out of range");
+            return element(index);
+        }
+
+        SEQUENCE_CONSTEXPR Int back() const
+        {
+            if(!length) throw std::out_of_range("back() called on an empty list");
+            return element(length-1);
+        }
+
+        // The sum of the elements, wrapping around on overflow.
+        // The range must be bounded.
+        SEQUENCE_CONSTEXPR Int sum() const
+        {
+            std::uint64_t n = length;
+            // n*(n-1)/2, dividing the even factor first
+            std::uint64_t triangle = n%2 ? n * ((n-1)/2) : (n/2) * (n-1);
+            return Int(n * wide(start) + triangle * wide(step));
+        }
+
+        // A range with random-access iterators
+        counting_range<Int> range() const
+        {
+            return {start, step, length};
+        }
+
+        // Takes up to count elements. Negative counts take no elements.
+        template<typename Count, typename = typename std::enable_if<std::is_integral<Count>::value>::type>
+        SEQUENCE_CONSTEXPR range_sequence take(Count count) const
+        {
+            std::uint64_t n = detail::element_count(count);
+            return with_length(start, n < length ? n : length, step);
+        }
+
+        // Skips up to count elements. Negative counts skip no elements.
+        template<typename Count, typename = typename std::enable_if<std::is_integral<Count>::value>::type>
+        SEQUENCE_CONSTEXPR range_sequence skip(Count count) const
+        {
+            std::uint64_t n = detail::element_count(count);
+            if(n > length) n = length;
+            return with_length(element(n), length==unbounded ? unbounded : length-n, step);
+        }
+
+        // Counts the elements matching p.
+        // The count is computed in closed form if p is a modulo<Int>.
+        template<typename Predicate, typename = typename std::enable_if<helpers::is_callable<Predicate, const Int&>::value>::type>
+        SEQUENCE_CONSTEXPR size_type count(Predicate p) const
+        {
+            return count(p, std::is_same<Predicate, modulo<Int>>());
+        }
+
+        // Counts the elements equal to value, in closed form
+        SEQUENCE_CONSTEXPR size_type count(Int value) const
+        {
+            std::uint64_t i0 = 0, period = 0;
+            if(!solve(value, i0, period) || i0 >= length) return 0;
+            // A period of 0 means 2^64, so there is only one solution
+            std::uint64_t n = period ? (length-1-i0) / period + 1 : 1;
+            return n > std::numeric_limits<size_type>::max() ? std::numeric_limits<size_type>::max() : size_type(n);
+        }
+
+        // The index of the first element equal to value, in closed form
+        SEQUENCE_CONSTEXPR size_type index_of(Int value) const
+        {
+            std::uint64_t i0 = 0, period = 0;
+            return solve(value, i0, period) && i0 < length && i0 <= std::numeric_limits<size_type>::max() ? size_type(i0) : this->npos;
+        }
+
+    private:
+        Int start;
+        step_type step;
+        std::uint64_t length, index;
+        Int current;
+
+        // Converts to 64 bits, so that arithmetic wraps around instead of overflowing
+        template<typename U>
+        static SEQUENCE_CONSTEXPR std::uint64_t wide(U x) { return std::uint64_t(x); }
+
+        SEQUENCE_CONSTEXPR Int element(std::uint64_t i) const
+        {
+            return Int(wide(start) + i * wide(step));
+        }
+
+        // Solves start + i*step = value for i, in the width of Int.
+        // The solutions are i0, i0+period, i0+2*period, ... where a period of 0 means 2^64.
+        SEQUENCE_CONSTEXPR bool solve(Int value, std::uint64_t & i0, std::uint64_t & period) const
+        {
+            const std::uint64_t mask = sizeof(Int) < 8 ? (std::uint64_t(1) << 8*sizeof(Int)%64) - 1 : ~std::uint64_t(0);
+            std::uint64_t target = (wide(value) - wide(start)) & mask, s = wide(step) & mask;
+            // s = odd * g, where g is a power of 2
+            std::uint64_t g = s & (0 - s), odd = s / g;
+            if(target % g) return false;
+            // Inverse of odd modulo 2^64 by Newton's method, which doubles the correct bits each step
+            std::uint64_t inverse = odd;
+            for(int k=0; k<5; ++k) inverse *= 2 - odd * inverse;
+            i0 = (target / g * inverse) & (mask / g);
+            period = mask / g + 1;
+            return true;
+        }
+
+        template<typename Predicate>
+        SEQUENCE_CONSTEXPR size_type count(Predicate p, std::false_type) const
+        {
+            return this->where(p).size();
+        }
+
+        // Solves start + i*step = remainder (mod divisor) for i
+        SEQUENCE_CONSTEXPR size_type count(const modulo<Int> & p, std::true_type) const
+        {
+            std::uint64_t d = wide(p.divisor);
+            std::uint64_t target = detail::sub_mod(wide(p.remainder), detail::residue(start, d), d);
+            std::uint64_t s = detail::residue(step, d);
+            std::uint64_t g = detail::gcd(s, d);
+            if(target % g) return 0;
+
+            // Solutions are i0, i0+period, i0+2*period, ...
+            std::uint64_t period = d / g;
+            std::uint64_t i0 = period==1 ? 0 : detail::mul_mod(target/g, detail::inverse_mod((s/g) % period, period), period);
+            if(i0 >= length) return 0;
+            std::uint64_t n = (length-1-i0) / period + 1;
+            return n > std::numeric_limits<size_type>::max() ? std::numeric_limits<size_type>::max() : size_type(n);
+        }
+    };
+
+    template<typename Int>
+    constexpr std::uint64_t range_sequence<Int>::unbounded;
+}
@@ -0,0 +1,281 @@
+// Implements ranges with standard iterators over sequences, returned by range().
+// Contiguous sequences give random-access ranges of pointers, integer ranges give
+// random-access ranges that compute their elements, and sequences whose copies are independent give forward ranges.
+// From C++20, these ranges are views that can be used with std::ranges and std::views.
+
+namespace sequences
+{
+    namespace detail
+    {
+#if defined(__cpp_lib_ranges)
+        typedef std::ranges::view_base view_base;
+#else
+        struct view_base {};
+#endif
+
+        // Holds at most one value, which can be destroyed
+        template<typename T>
+        class stash
+        {
+        public:
+            stash() : full(false) {}
+            stash(const stash & other) : full(false) { if(other.full) set(other.get()); }
+            stash & operator=(const stash & other)
+            {
+                if(this != &other)
+                {
+                    reset();
+                    if(other.full) set(other.get());
+                }
+                return *this;
+            }
+            ~stash() { reset(); }
+
+            const T & set(const T & value)
+            {
+                reset();
+                new(storage) T(value);
+                full = true;
+                return get();
+            }
+
+            void reset()
+            {
+                if(full) get().~T();
+                full = false;
+            }
+
+            const T & get() const { return *reinterpret_cast<const T*>(storage); }
+
+        private:
+            alignas(T) unsigned char storage[sizeof(T)];
+            bool full;
+        };
+    }
+
+    // The elements of a contiguous sequence, whose iterators are pointers
+    template<typename T>
+    class contiguous_range : public detail::view_base
+    {
+    public:
+        typedef T value_type;
+        typedef const T * iterator;
+        typedef const T * const_iterator;
+        typedef std::size_t size_type;
+
+        contiguous_range() : from(nullptr), to(nullptr) {}
+        contiguous_range(const T * from, const T * to) : from(from), to(to) {}
+
+        iterator begin() const { return from; }
+        iterator end() const { return to; }
+        const T * data() const { return from; }
+        size_type size() const { return to - from; }
+        bool empty() const { return from == to; }
+        const T & operator[](size_type i) const { return from[i]; }
+
+    private:
+        const T *from, *to;
+    };
+
+    // The integers start, start+step, start+2*step, ... with random-access iterators.
+    // Like std::vector<bool>, iterators return their elements by value.
+    template<typename Int>
+    class counting_range : public detail::view_base
+    {
+    public:
+        typedef Int value_type;
+        typedef std::size_t size_type;
+        typedef typename std::make_signed<Int>::type step_type;
+
+        class iterator
+        {
+        public:
+            typedef Int value_type;
+            typedef Int reference;
+            typedef void pointer;
+            typedef std::ptrdiff_t difference_type;
+            typedef std::random_access_iterator_tag iterator_category;
+
+            iterator() : start(), step(1), index(0) {}
+            iterator(Int start, step_type step, difference_type index) : start(start), step(step), index(index) {}
+
+            reference operator*() const { return element(index); }
+            reference operator[](difference_type n) const { return element(index + n); }
+
+            iterator & operator+=(difference_type n)
+            {
+                index += n;
+                return *this;
+            }
+
+            iterator & operator-=(difference_type n) { return *this += -n; }
+            iterator & operator++() { return *this += 1; }
+            iterator & operator--() { return *this += -1; }
+            iterator operator++(int) { iterator result = *this; ++*this; return result; }
+            iterator operator--(int) { iterator result = *this; --*this; return result; }
+
+            friend iterator operator+(iterator i, difference_type n) { return i += n; }
+            friend iterator operator+(difference_type n, iterator i) { return i += n; }
+            friend iterator operator-(iterator i, difference_type n) { return i -= n; }
+            friend difference_type operator-(const iterator & a, const iterator & b) { return a.index - b.index; }
+
+            friend bool operator==(const iterator & a, const iterator & b) { return a.index == b.index; }
+            friend bool operator!=(const iterator & a, const iterator & b) { return a.index != b.index; }
+            friend bool operator<(const iterator & a, const iterator & b) { return a.index < b.index; }
+            friend bool operator>(const iterator & a, const iterator & b) { return a.index > b.index; }
+            friend bool operator<=(const iterator & a, const iterator & b) { return a.index <= b.index; }
+            friend bool operator>=(const iterator & a, const iterator & b) { return a.index >= b.index; }
+
+        private:
+            Int start;
+            step_type step;
+            difference_type index;
+
+            // Arithmetic wraps around in 64 bits, like range_sequence
+            Int element(difference_type i) const { return Int(std::uint64_t(start) + std::uint64_t(i) * std::uint64_t(step)); }
+        };
+
+        typedef iterator const_iterator;
+
+        counting_range() : start(), step(1), length(0) {}
+
+        // The length must be at most PTRDIFF_MAX
+        counting_range(Int start, step_type step, std::uint64_t length) : start(start), step(step),
+            length(std::ptrdiff_t(std::min<std::uint64_t>(length, std::numeric_limits<std::ptrdiff_t>::max()))) {}
+
+        iterator begin() const { return iterator(start, step, 0); }
+        iterator end() const { return iterator(start, step, length); }
+        size_type size() const { return size_type(length); }
+        bool empty() const { return !length; }
+        value_type operator[](size_type i) const { return begin()[i]; }
+
+    private:
+        Int start;
+        step_type step;
+        std::ptrdiff_t length;
+    };
+
+    // The elements of a sequence whose copies can be iterated independently, with forward iterators.
+    //
+    // Each iterator that is incremented evaluates its own copy of the sequence, so that
+    // copies of iterators are independent. A copy of an iterator holds a copy of the current
+    // element, and only evaluates the sequence (skipping to its position) if it is incremented,
+    // so algorithms that remember positions, such as std::max_element(), stay linear.
+    template<typename Seq>
+    class forward_range : public detail::view_base
+    {
+    public:
+        typedef typename Seq::value_type value_type;
+
+        class iterator
+        {
+        public:
+            typedef typename Seq::value_type value_type;
+            typedef const value_type & reference;
+            typedef const value_type * pointer;
+            typedef std::ptrdiff_t difference_type;
+            typedef std::forward_iterator_tag iterator_category;
+
+            // The end of the range
+            iterator() : current(nullptr), index(0) {}
+
+            explicit iterator(const std::shared_ptr<const Seq> & source) : source(source), cursor(new Seq(*source)), index(0)
+            {
+                current = cursor->first();
+                if(!current) finish();
+            }
+
+            // Copies do not share the evaluation of the sequence
+            iterator(const iterator & other) : source(other.source), current(nullptr), index(other.index)
+            {
+                if(other.current) current = &value.set(*other.current);
+            }
+
+            iterator(iterator && other) : current(nullptr), index(0)
+            {
+                *this = std::move(other);
+            }
+
+            iterator & operator=(const iterator & other)
+            {
+                if(this != &other) *this = iterator(other);
+                return *this;
+            }
+
+            iterator & operator=(iterator && other)
+            {
+                if(this != &other)
+                {
+                    source = std::move(other.source);
+                    cursor = std::move(other.cursor);
+                    value = other.value;
+                    index = other.index;
+                    // An element without a cursor is in the stash
+                    current = other.current && !cursor ? &value.get() : other.current;
+                }
+                return *this;
+            }
+
+            reference operator*() const { return *current; }
+            pointer operator->() const { return current; }
+
+            iterator & operator++()
+            {
+                if(!cursor)
+                {
+                    // Evaluate a copy of the sequence up to the current position
+                    cursor.reset(new Seq(*source));
+                    cursor->first();
+                    for(difference_type i=0; i<index; ++i)
+                        cursor->next();
+                }
+                value.reset();
+                current = cursor->next();
+                ++index;
+                if(!current) finish();
+                return *this;
+            }
+
+            iterator operator++(int)
+            {
+                iterator result = *this;
+                ++*this;
+                return result;
+            }
+
+            // Iterators of the same range are equal if they are at the same position
+            friend bool operator==(const iterator & a, const iterator & b)
+            {
+                return a.current && b.current ? a.index == b.index : a.current == b.current;
+            }
+
+            friend bool operator!=(const iterator & a, const iterator & b) { return !(a == b); }
+
+        private:
+            std::shared_ptr<const Seq> source;
+            std::unique_ptr<Seq> cursor;
+            detail::stash<value_type> value;
+            const value_type * current;
+            difference_type index;
+
+            void finish()
+            {
+                current = nullptr;
+                cursor.reset();
+                source.reset();
+            }
+        };
+
+        typedef iterator const_iterator;
+
+        forward_range() {}
+        explicit forward_range(const Seq & seq) : source(std::make_shared<const Seq>(seq)) {}
+        explicit forward_range(Seq && seq) : source(std::make_shared<const Seq>(std::move(seq))) {}
+
+        iterator begin() const { return source ? iterator(source) : iterator(); }
+        iterator end() const { return iterator(); }
+
+    private:
+        std::shared_ptr<const Seq> source;
+    };
+}
@@ -0,0 +1,236 @@
+// Implements a framed binary file format for storing sequences between batch stages.
+//
+// A record file starts with a 64-byte header containing the element count, followed by the elements.
+// Trivially copyable elements are stored as one raw block, which starts at a 64-byte aligned offset
+// so that it can be memory-mapped and used in place. Other elements are stored as records
+// using sequences::serializer<T>, where strings are prefixed by their length.
+// Data is stored in the byte order of the machine that wrote it.
+
+namespace sequences
+{
+    namespace detail
+    {
+        struct record_header
+        {
+            char magic[8];
+            std::uint32_t flags, element_size;
+            std::uint64_t count, data_offset;
+            char reserved[32];
+
+            static const std::uint32_t raw = 1;
+            // The count of a file that was not closed
+            static const std::uint64_t incomplete = ~std::uint64_t(0);
+
+            static const char * signature() { return "SEQREC01"; }
+        };
+
+        static_assert(sizeof(record_header) == 64, "Unexpected record header size");
+
+        // An open record file, whose raw data is memory-mapped or read into memory
+        class record_source
+        {
+        public:
+            template<typename T>
+            static std::shared_ptr<record_source> open(const char * path)
+            {
+                std::shared_ptr<record_source> source(new record_source(std::fopen(path, "rb")));
+                if(!source->file) throw std::runtime_error("Could not open record file");
+
+                auto & h = source->header;
+                if(std::fread(&h, sizeof(h), 1, source->file) != 1 || std::memcmp(h.magic, record_header::signature(), 8))
+                    throw std::runtime_error("Not a record file");
+                if(h.count == record_header::incomplete)
+                    throw std::runtime_error("Record file was not closed");
+                if(bool(h.flags & record_header::raw) != std::is_trivially_copyable<T>::value ||
+                    (std::is_trivially_copyable<T>::value && h.element_size != sizeof(T)))
+                    throw std::runtime_error("Record file has the wrong element type");
+
+                if(std::is_trivially_copyable<T>::value) source->load(h.count * sizeof(T));
+                return source;
+            }
+
+            ~record_source()
+            {
+#if SEQUENCE_ENABLE_POSIX
+                if(mapping) ::munmap(mapping, mapping_size);
+#endif
+                if(file) std::fclose(file);
+            }
+
+            record_header header;
+            std::FILE * file;
+
+            // The raw elements
+            const char * data() const { return mapping ? static_cast<const char*>(mapping) + header.data_offset : copy.get(); }
+
+        private:
+            explicit record_source(std::FILE * file) : header(), file(file), mapping(nullptr), mapping_size(0) {}
+
+            void * mapping;
+            std::size_t mapping_size;
+            byte_buffer copy;
+
+            // Maps the data into memory, or reads it if it cannot be mapped
+            void load(std::uint64_t size)
+            {
+                if(!size) return;
+#if SEQUENCE_ENABLE_POSIX
+                struct stat st;
+                if(::fstat(fileno(file), &st) || std::uint64_t(st.st_size) < header.data_offset + size)
+                    throw std::runtime_error("Record file is truncated");
+                mapping_size = std::size_t(header.data_offset + size);
+                mapping = ::mmap(nullptr, mapping_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+                if(mapping == MAP_FAILED)
+                    mapping = nullptr;
+                else
+                {
+                    ::madvise(mapping, mapping_size, MADV_SEQUENTIAL);
+                    return;
+                }
+#endif
+                copy.reset(std::size_t(size));
+                if(!seek(file, header.data_offset) || std::fread(copy.get(), 1, std::size_t(size), file) != size)
+                    throw std::runtime_error("Record file is truncated");
+            }
+        };
+    }
+
+    // An output sequence that writes elements to a record file.
+    // The element count is written to the header when the output is closed or destroyed.
+    template<typename T>
+    class record_output : public output_sequence<T>
+    {
+    public:
+        explicit record_output(const char * path, std::size_t capacity = 1<<20) :
+            file(std::fopen(path, "wb")), output(file, sizeof(detail::record_header), capacity), count(0)
+        {
+            if(!file) throw std::runtime_error("Could not create record file");
+            write_header(detail::record_header::incomplete);
+        }
+
+        record_output(record_output && other) :
+            file(other.file), output(std::move(other.output)), count(other.count)
+        {
+            other.file = nullptr;
+        }
+
+        ~record_output()
+        {
+            try { close(); } catch(...) {}
+        }
+
+        void add(const T & item) const override
+        {
+            put(item, std::is_trivially_copyable<T>());
+            ++count;
+        }
+
+        void add_range(const T * begin, const T * end) const override
+        {
+            put_range(begin, end, std::is_trivially_copyable<T>());
+            count += end-begin;
+        }
+
+        // Writes the remaining elements and the header, and closes the file
+        void close()
+        {
+            if(!file) return;
+            output.flush();
+            write_header(count);
+            std::fclose(file);
+            file = nullptr;
+        }
+
+        // The number of elements written so far
+        std::uint64_t size() const { return count; }
+
+    private:
+        std::FILE * file;
+        mutable binary_output output;
+        mutable std::uint64_t count;
+
+        void write_header(std::uint64_t n)
+        {
+            detail::record_header header = {};
+            std::memcpy(header.magic, detail::record_header::signature(), 8);
+            header.flags = std::is_trivially_copyable<T>::value ? detail::record_header::raw : 0;
+            header.element_size = std::is_trivially_copyable<T>::value ? sizeof(T) : 0;
+            header.count = n;
+            header.data_offset = sizeof(header);
+            if(!detail::seek(file, 0) || std::fwrite(&header, sizeof(header), 1, file) != 1 || std::fflush(file))
+                throw std::runtime_error("Failed to write record file");
+        }
+
+        void put(const T & item, std::true_type) const { output.write(&item, sizeof(T)); }
+
+        void put(const T & item, std::false_type) const { serializer<T>::write(output, item); }
+
+        void put_range(const T * begin, const T * end, std::true_type) const { output.write(begin, (end-begin)*sizeof(T)); }
+
+        void put_range(const T * begin, const T * end, std::false_type) const
+        {
+            for(; begin!=end; ++begin) serializer<T>::write(output, *begin);
+        }
+    };
+
+    // Reads a record file. Trivially copyable elements are used in place,
+    // so this is a pointer_sequence<T> that is valid while the record_file exists.
+    template<typename T, bool Raw>
+    class record_file : public pointer_sequence<T>
+    {
+        static_assert(alignof(T) <= sizeof(detail::record_header), "Elements must be aligned to at most 64 bytes");
+    public:
+        explicit record_file(const char * path) : record_file(detail::record_source::open<T>(path)) {}
+
+    private:
+        std::shared_ptr<detail::record_source> source;
+
+        explicit record_file(const std::shared_ptr<detail::record_source> & source) :
+            pointer_sequence<T>(reinterpret_cast<const T*>(source->data()), reinterpret_cast<const T*>(source->data()) + source->header.count),
+            source(source)
+        {
+        }
+    };
+
+    // Reads a record file of elements that are stored as records.
+    // The file is read each time the sequence is iterated.
+    template<typename T>
+    class record_file<T, false> : public base_sequence<T, record_file<T, false>>
+    {
+    public:
+        typedef T value_type;
+        typedef std::size_t size_type;
+
+        explicit record_file(const char * path) : source(detail::record_source::open<T>(path)), index(0), current() {}
+
+        typedef void is_sized;
+
+        size_type size() const { return size_type(source->header.count); }
+
+        const T * first()
+        {
+            input.seek(source->file, source->header.data_offset);
+            index = 0;
+            return fetch();
+        }
+
+        const T * next()
+        {
+            ++index;
+            return fetch();
+        }
+
+    private:
+        std::shared_ptr<detail::record_source> source;
+        binary_input input;
+        std::uint64_t index;
+        T current;
+
+        const T * fetch()
+        {
+            if(index >= source->header.count) return nullptr;
+            if(!serializer<T>::read(input, current)) throw std::runtime_error("Record file is truncated");
+            return &current;
+        }
+    };
+}
@@ -22,5 +22,22 @@ namespace sequences
             if(result) return result;
             return ++index<repeat ? seq.first() : nullptr;
         }
+
+        typedef typename std::conditional<helpers::is_reversible<Seq>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_multipass<Seq>::value, void, int>::type is_multipass;
+
+        const typename Seq::value_type * last()
+        {
+            index=0;
+            return repeat>0 ? seq.last() : nullptr;
+        }
+
+        const typename Seq::value_type * prev()
+        {
+            auto result = seq.prev();
+            if(result) return result;
+            return ++index<repeat ? seq.last() : nullptr;
+        }
     };
 }
@@ -0,0 +1,94 @@
+// Implements sequences that iterate another sequence in reverse order.
+
+namespace sequences
+{
+    // Reverses a sequence that can be iterated backwards in place.
+    // The underlying sequence implements last() and prev().
+    template<typename Seq>
+    class reverse_sequence : public base_sequence<typename Seq::value_type, reverse_sequence<Seq>>
+    {
+        Seq seq;
+    public:
+        typedef typename Seq::value_type value_type;
+        typedef void is_reversible;
+        typedef typename std::conditional<helpers::is_multipass<Seq>::value, void, int>::type is_multipass;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_sized<Seq>::value, void, int>::type is_sized;
+
+        reverse_sequence(const Seq & seq) : seq(seq) {}
+
+        const value_type * first() { return seq.last(); }
+        const value_type * next() { return seq.prev(); }
+        const value_type * last() { return seq.first(); }
+        const value_type * prev() { return seq.next(); }
+
+        std::size_t size() const { return seq.size(); }
+
+        // Reversing the sequence again gives the original sequence
+        Seq reverse() const { return seq; }
+    };
+
+    // Reverses a forward-only sequence by buffering its elements.
+    template<typename Seq>
+    class reverse_buffer_sequence : public base_sequence<typename Seq::value_type, reverse_buffer_sequence<Seq>>
+    {
+        Seq seq;
+    public:
+        typedef typename Seq::value_type value_type;
+        typedef void is_reversible;
+
+        reverse_buffer_sequence(const Seq & seq) : seq(seq) {}
+
+        const value_type * first()
+        {
+            fill();
+            current = buffer.last_chunk();
+            if(!current) return nullptr;
+            index = current->size-1;
+            return current->items + index;
+        }
+
+        const value_type * next()
+        {
+            if(!current) return nullptr;
+            if(index>0) return current->items + --index;
+            current = current->prev;
+            if(!current) return nullptr;
+            index = current->size-1;
+            return current->items + index;
+        }
+
+        const value_type * last()
+        {
+            fill();
+            current = buffer.first_chunk();
+            index = 0;
+            return current ? current->items : nullptr;
+        }
+
+        const value_type * prev()
+        {
+            if(!current) return nullptr;
+            if(++index < current->size) return current->items + index;
+            current = current->next;
+            index = 0;
+            if(current && !current->size) current = nullptr;
+            if(!current) return nullptr;
+            return current->items;
+        }
+
+        std::size_t size() const { return seq.size(); }
+
+    private:
+        chunked_buffer<value_type> buffer;
+        const typename chunked_buffer<value_type>::chunk * current;
+        std::size_t index;
+
+        void fill()
+        {
+            buffer.clear();
+            for(auto i = seq.first(); i; i = seq.next())
+                buffer.push_back(*i);
+        }
+    };
+}
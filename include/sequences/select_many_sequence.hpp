@@ -0,0 +1,213 @@
+// Implements sequences that flatten a sequence of sequences.
+
+namespace sequences
+{
+    // Maps each element to a sequence using a functor, and iterates the elements
+    // of each inner sequence in turn.
+    // The inner sequence is constructed in place, so no memory is allocated, and is
+    // assigned for each outer element if it is move-assignable.
+    // Blocks are the contiguous runs (or the blocks) of each inner sequence.
+    template<typename Seq, typename Fn>
+    class select_many_sequence : public base_sequence<
+        typename helpers::remove_all<decltype(std::declval<Fn&>()(std::declval<const typename Seq::value_type&>()))>::type::value_type,
+        select_many_sequence<Seq, Fn>>
+    {
+        typedef typename Seq::value_type outer_type;
+        typedef typename helpers::remove_all<decltype(std::declval<Fn&>()(std::declval<const outer_type&>()))>::type inner_type;
+    public:
+        typedef typename inner_type::value_type value_type;
+
+        select_many_sequence(const Seq & seq, Fn fn) : seq(seq), fn(fn), has_inner(false) {}
+
+        // Copies do not copy the current inner sequence
+        select_many_sequence(const select_many_sequence & other) : seq(other.seq), fn(other.fn), has_inner(false) {}
+
+        select_many_sequence & operator=(const select_many_sequence &) = delete;
+
+        ~select_many_sequence() { reset(); }
+
+        const value_type * first()
+        {
+            return start(seq.first());
+        }
+
+        const value_type * next()
+        {
+            if(!has_inner) return nullptr;
+            auto result = inner().next();
+            return result ? result : start(seq.next());
+        }
+
+        typedef typename std::conditional<std::is_arithmetic<value_type>::value &&
+            (helpers::is_contiguous<inner_type>::value || helpers::is_blockwise<inner_type>::value), void, int>::type is_blockwise;
+
+        const value_type * first_block(value_type * buffer, std::size_t & n)
+        {
+            return start_block(seq.first(), buffer, n);
+        }
+
+        const value_type * next_block(value_type * buffer, std::size_t & n)
+        {
+            if(!has_inner)
+            {
+                n = 0;
+                return buffer;
+            }
+            std::size_t capacity = n;
+            auto block = inner_block(false, buffer, n, helpers::is_contiguous<inner_type>());
+            return n ? block : start_block(seq.next(), buffer, n = capacity);
+        }
+
+    private:
+        Seq seq;
+        Fn fn;
+        alignas(inner_type) unsigned char storage[sizeof(inner_type)];
+        bool has_inner;
+
+        // The rest of the current contiguous inner sequence
+        const value_type *position, *limit;
+
+        inner_type & inner() { return *reinterpret_cast<inner_type*>(storage); }
+
+        void reset()
+        {
+            if(has_inner) inner().~inner_type();
+            has_inner = false;
+        }
+
+        // Sets the inner sequence for an outer element, reusing the current one if possible
+        void assign(const outer_type & outer)
+        {
+            if(has_inner)
+                assign(outer, std::is_move_assignable<inner_type>());
+            else
+            {
+                new(storage) inner_type(fn(outer));
+                has_inner = true;
+            }
+        }
+
+        void assign(const outer_type & outer, std::true_type)
+        {
+            inner() = fn(outer);
+        }
+
+        void assign(const outer_type & outer, std::false_type)
+        {
+            reset();
+            new(storage) inner_type(fn(outer));
+            has_inner = true;
+        }
+
+        // Finds the first element of the inner sequences, starting at the given outer element
+        const value_type * start(const outer_type * outer)
+        {
+            for(; outer; outer = seq.next())
+            {
+                assign(*outer);
+                auto result = inner().first();
+                if(result) return result;
+            }
+            reset();
+            return nullptr;
+        }
+
+        // Finds the first non-empty block of the inner sequences, starting at the given outer element
+        const value_type * start_block(const outer_type * outer, value_type * buffer, std::size_t & n)
+        {
+            std::size_t capacity = n;
+            for(; outer; outer = seq.next())
+            {
+                assign(*outer);
+                auto block = inner_block(true, buffer, n = capacity, helpers::is_contiguous<inner_type>());
+                if(n) return block;
+            }
+            reset();
+            n = 0;
+            return buffer;
+        }
+
+        const value_type * inner_block(bool first, value_type *, std::size_t & n, std::true_type)
+        {
+            if(first)
+            {
+                position = inner().data();
+                limit = position + inner().size();
+            }
+            if(n > std::size_t(limit - position)) n = limit - position;
+            auto block = position;
+            position += n;
+            return block;
+        }
+
+        const value_type * inner_block(bool first, value_type * buffer, std::size_t & n, std::false_type)
+        {
+            return first ? inner().first_block(buffer, n) : inner().next_block(buffer, n);
+        }
+    };
+
+    // Calls a functor on each element to write elements to an output_sequence,
+    // and iterates the elements that were written.
+    // The elements are stored in a buffer that is reused for each element.
+    template<typename Seq, typename Fn>
+    class select_many_output_sequence : public base_sequence<typename helpers::deduce_output<Fn>::type, select_many_output_sequence<Seq, Fn>>
+    {
+        typedef typename Seq::value_type outer_type;
+    public:
+        typedef typename helpers::deduce_output<Fn>::type value_type;
+
+        select_many_output_sequence(const Seq & seq, Fn fn) : seq(seq), fn(fn), current(nullptr) {}
+
+        const value_type * first()
+        {
+            return start(seq.first());
+        }
+
+        const value_type * next()
+        {
+            if(!current) return nullptr;
+            if(++index < current->size) return current->items + index;
+            if(current->next && current->next->size)
+            {
+                current = current->next;
+                index = 0;
+                return current->items;
+            }
+            return start(seq.next());
+        }
+
+    private:
+        Seq seq;
+        Fn fn;
+        chunked_buffer<value_type> buffer;
+        const typename chunked_buffer<value_type>::chunk * current;
+        std::size_t index;
+
+        // An output_sequence that writes to the buffer
+        class buffer_writer : public output_sequence<value_type>
+        {
+            chunked_buffer<value_type> & buffer;
+        public:
+            buffer_writer(chunked_buffer<value_type> & buffer) : buffer(buffer) {}
+
+            void add(const value_type & item) const override { buffer.push_back(item); }
+        };
+
+        const value_type * start(const outer_type * outer)
+        {
+            for(; outer; outer = seq.next())
+            {
+                buffer.clear();
+                fn(*outer, buffer_writer(buffer));
+                current = buffer.first_chunk();
+                if(current)
+                {
+                    index = 0;
+                    return current->items;
+                }
+            }
+            current = nullptr;
+            return nullptr;
+        }
+    };
+}
@@ -12,9 +12,9 @@ namespace sequences
     private:
         value_type current;
     public:
-        select_sequence(const Seq &seq, Fn fn) : seq(seq), fn(fn) {}
+        SEQUENCE_CONSTEXPR select_sequence(const Seq &seq, Fn fn) : seq(seq), fn(fn), current() {}
 
-        const value_type * first()
+        SEQUENCE_CONSTEXPR const value_type * first()
         {
             const T * result = seq.first();
             if(result)
@@ -28,7 +28,7 @@ namespace sequences
             }
         }
 
-        const value_type * next()
+        SEQUENCE_CONSTEXPR const value_type * next()
         {
             const T * result = seq.next();
             if(result)
@@ -42,6 +42,81 @@ namespace sequences
             }
         }
 
-        std::size_t size() const { return seq.size(); }
+        typedef typename std::conditional<helpers::is_reversible<Seq>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_sized<Seq>::value, void, int>::type is_sized;
+        typedef typename std::conditional<helpers::is_blockwise<Seq>::value &&
+            std::is_arithmetic<T>::value && std::is_arithmetic<value_type>::value, void, int>::type is_blockwise;
+
+        // Maps the whole block, which the compiler can vectorize
+        const value_type * first_block(value_type * buffer, std::size_t & n)
+        {
+            T input[helpers::block_size];
+            auto block = seq.first_block(input, n);
+            return map_block(block, buffer, n);
+        }
+
+        const value_type * next_block(value_type * buffer, std::size_t & n)
+        {
+            T input[helpers::block_size];
+            auto block = seq.next_block(input, n);
+            return map_block(block, buffer, n);
+        }
+
+        // Carries the selection mask of where() through, so that where().select().sum()
+        // does not compact the elements. Only the selected elements are mapped.
+        typedef typename std::conditional<helpers::is_masked<Seq>::value &&
+            std::is_arithmetic<T>::value && std::is_arithmetic<value_type>::value, void, int>::type is_masked;
+
+        const value_type * first_masked_block(value_type * buffer, typename detail::lane_mask<value_type>::type * mask, std::size_t & n)
+        {
+            T input[helpers::block_size];
+            typename detail::lane_mask<T>::type input_mask[helpers::block_size];
+            auto block = seq.first_masked_block(input, input_mask, n);
+            return map_masked_block(block, input_mask, buffer, mask, n);
+        }
+
+        const value_type * next_masked_block(value_type * buffer, typename detail::lane_mask<value_type>::type * mask, std::size_t & n)
+        {
+            T input[helpers::block_size];
+            typename detail::lane_mask<T>::type input_mask[helpers::block_size];
+            auto block = seq.next_masked_block(input, input_mask, n);
+            return map_masked_block(block, input_mask, buffer, mask, n);
+        }
+
+        SEQUENCE_CONSTEXPR const value_type * last()
+        {
+            const T * result = seq.last();
+            if(!result) return nullptr;
+            current = fn(*result);
+            return &current;
+        }
+
+        SEQUENCE_CONSTEXPR const value_type * prev()
+        {
+            const T * result = seq.prev();
+            if(!result) return nullptr;
+            current = fn(*result);
+            return &current;
+        }
+
+        SEQUENCE_CONSTEXPR std::size_t size() const { return seq.size(); }
+
+    private:
+        const value_type * map_block(const T * block, value_type * buffer, std::size_t n)
+        {
+            detail::for_each_lane(n, [&](std::size_t i) { buffer[i] = fn(block[i]); });
+            return buffer;
+        }
+
+        // Unselected lanes are zero, so that fn is not called on elements that where() rejected
+        template<typename Mask>
+        const value_type * map_masked_block(const T * block, const Mask * input_mask, value_type * buffer,
+            typename detail::lane_mask<value_type>::type * mask, std::size_t n)
+        {
+            detail::for_each_lane(n, [&](std::size_t i) { buffer[i] = input_mask[i] ? fn(block[i]) : value_type(); });
+            detail::convert_mask<value_type>(input_mask, n, mask);
+            return buffer;
+        }
     };
 }
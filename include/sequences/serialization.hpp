@@ -0,0 +1,216 @@
+// Buffered binary file I/O and the serialization of elements.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // Seeks to an absolute 64-bit offset in a file
+        inline bool seek(std::FILE * file, std::uint64_t offset)
+        {
+#if defined(_WIN32)
+            return _fseeki64(file, (__int64)offset, SEEK_SET)==0;
+#else
+            return fseeko(file, (off_t)offset, SEEK_SET)==0;
+#endif
+        }
+    }
+
+    // Writes bytes to a file through a large buffer.
+    // The file is written at the given offset, so it can share the file with a binary_input.
+    class binary_output
+    {
+    public:
+        binary_output(std::FILE * file=nullptr, std::uint64_t offset=0, std::size_t capacity=1<<20) :
+            file(file), offset(offset), length(0), capacity(capacity), buffer(capacity) {}
+
+        binary_output(binary_output && other) :
+            file(other.file), offset(other.offset), length(other.length), capacity(other.capacity), buffer(std::move(other.buffer))
+        {
+            other.file = nullptr;
+        }
+
+        ~binary_output()
+        {
+            try { flush(); } catch(...) {}
+        }
+
+        void open(std::FILE * f, std::uint64_t off=0) { flush(); file = f; offset = off; }
+
+        void write(const void * data, std::size_t size)
+        {
+            if(length + size > capacity)
+            {
+                flush();
+                if(size > capacity)
+                {
+                    // Write large blocks directly
+                    write_file(data, size);
+                    return;
+                }
+            }
+            std::memcpy(buffer.get()+length, data, size);
+            length += size;
+        }
+
+        // Writes all buffered data to the file
+        void flush()
+        {
+            if(length && file) write_file(buffer.get(), length);
+            length = 0;
+        }
+
+        // The file offset after all data written so far
+        std::uint64_t position() const { return offset + length; }
+
+    private:
+        std::FILE * file;
+        std::uint64_t offset;
+        std::size_t length, capacity;
+        detail::byte_buffer buffer;
+
+        void write_file(const void * data, std::size_t size)
+        {
+            if(!detail::seek(file, offset) || std::fwrite(data, 1, size, file) != size || std::fflush(file))
+                throw std::runtime_error("Failed to write to file");
+            offset += size;
+        }
+    };
+
+    // Reads bytes from a file through a large buffer, starting at a given offset.
+    class binary_input
+    {
+    public:
+        binary_input(std::FILE * file=nullptr, std::uint64_t offset=0, std::size_t capacity=1<<20) :
+            file(file), offset(offset), position(0), length(0), capacity(capacity) {}
+
+        // Copying an input copies the file position but not the buffer
+        binary_input(const binary_input & other) :
+            file(other.file), offset(other.offset - other.length + other.position), position(0), length(0), capacity(other.capacity) {}
+
+        binary_input & operator=(const binary_input & other)
+        {
+            seek(other.file, other.offset - other.length + other.position);
+            return *this;
+        }
+
+        // Moves to a new file position, discarding the buffer
+        void seek(std::FILE * f, std::uint64_t off)
+        {
+            file = f;
+            offset = off;
+            position = length = 0;
+        }
+
+        bool is_open() const { return file; }
+
+        // Reads exactly size bytes, or returns false at the end of the file
+        bool read(void * data, std::size_t size)
+        {
+            char * out = static_cast<char*>(data);
+            while(size)
+            {
+                if(position == length && !fill()) return false;
+                std::size_t n = std::min(size, length-position);
+                std::memcpy(out, buffer.get()+position, n);
+                position += n;
+                out += n;
+                size -= n;
+            }
+            return true;
+        }
+
+        // Reads up to size bytes directly from the file, bypassing the buffer.
+        std::size_t read_block(void * data, std::size_t size)
+        {
+            std::size_t n = std::min(size, length-position);
+            if(n) std::memcpy(data, buffer.get()+position, n);
+            position += n;
+            if(n < size && file && detail::seek(file, offset))
+            {
+                std::size_t m = std::fread(static_cast<char*>(data)+n, 1, size-n, file);
+                offset += m;
+                n += m;
+            }
+            return n;
+        }
+
+    private:
+        std::FILE * file;
+        std::uint64_t offset;
+        std::size_t position, length, capacity;
+        detail::byte_buffer buffer;
+
+        bool fill()
+        {
+            if(!file) return false;
+            if(!buffer) buffer.reset(capacity);
+            if(!detail::seek(file, offset)) return false;
+            length = std::fread(buffer.get(), 1, capacity, file);
+            position = 0;
+            offset += length;
+            return length>0;
+        }
+    };
+
+    // Defines how elements are written to and read from binary files.
+    // Trivially copyable types are stored as raw bytes, and strings are stored
+    // as a 64-bit length followed by the characters.
+    // Specialize this class to serialize other types.
+    template<typename T, typename = void>
+    struct serializer
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Specialize sequences::serializer<T> to serialize this type");
+
+        static void write(binary_output & out, const T & item) { out.write(&item, sizeof(T)); }
+
+        static bool read(binary_input & in, T & item) { return in.read(&item, sizeof(T)); }
+
+        // The approximate memory used by an item
+        static std::size_t footprint(const T &) { return sizeof(T); }
+    };
+
+    template<typename Ch, typename Traits, typename Alloc>
+    struct serializer<std::basic_string<Ch, Traits, Alloc>>
+    {
+        typedef std::basic_string<Ch, Traits, Alloc> type;
+
+        static void write(binary_output & out, const type & item)
+        {
+            std::uint64_t length = item.size();
+            out.write(&length, sizeof(length));
+            out.write(item.data(), length*sizeof(Ch));
+        }
+
+        static bool read(binary_input & in, type & item)
+        {
+            std::uint64_t length;
+            if(!in.read(&length, sizeof(length))) return false;
+            item.resize(length);
+            return in.read(&item[0], length*sizeof(Ch));
+        }
+
+        static std::size_t footprint(const type & item) { return sizeof(type) + item.capacity()*sizeof(Ch); }
+    };
+
+    template<typename T1, typename T2>
+    struct serializer<std::pair<T1,T2>, typename std::enable_if<!std::is_trivially_copyable<std::pair<T1,T2>>::value>::type>
+    {
+        typedef std::pair<T1,T2> type;
+
+        static void write(binary_output & out, const type & item)
+        {
+            serializer<T1>::write(out, item.first);
+            serializer<T2>::write(out, item.second);
+        }
+
+        static bool read(binary_input & in, type & item)
+        {
+            return serializer<T1>::read(in, item.first) && serializer<T2>::read(in, item.second);
+        }
+
+        static std::size_t footprint(const type & item)
+        {
+            return serializer<T1>::footprint(item.first) + serializer<T2>::footprint(item.second);
+        }
+    };
+}
@@ -0,0 +1,128 @@
+// Implements set operations on sorted sequences.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // Advances seq to the first element that is not less than value.
+        // Sequences that support seek() skip ahead using a galloping search.
+        template<typename Seq, typename T, typename Less>
+        const T * seek(Seq & seq, const T * current, const T & value, Less & less, std::true_type)
+        {
+            return current && less(*current, value) ? seq.seek(value, less) : current;
+        }
+
+        template<typename Seq, typename T, typename Less>
+        const T * seek(Seq & seq, const T * current, const T & value, Less & less, std::false_type)
+        {
+            while(current && less(*current, value))
+                current = seq.next();
+            return current;
+        }
+    }
+
+    // Combines two sorted sequences in a single pass, in the same way as std::set_union(),
+    // std::set_intersection(), std::set_difference() and std::set_symmetric_difference().
+    // Both sequences must be sorted according to Less.
+    //
+    // When the other sequence is ahead, intersection and difference skip over elements using
+    // seek(), which takes O(log n) steps on random-access sequences.
+    template<typename Seq1, typename Seq2, typename Less, set_operation Op>
+    class set_sequence : public base_sequence<typename Seq1::value_type, set_sequence<Seq1, Seq2, Less, Op>>
+    {
+    public:
+        typedef typename Seq1::value_type value_type;
+
+        set_sequence(const Seq1 & seq1, const Seq2 & seq2, Less less) : seq1(seq1), seq2(seq2), less(less) {}
+
+        const value_type * first()
+        {
+            h1 = seq1.first();
+            h2 = seq2.first();
+            return find();
+        }
+
+        const value_type * next()
+        {
+            if(advance1) h1 = seq1.next();
+            if(advance2) h2 = seq2.next();
+            return find();
+        }
+
+    private:
+        Seq1 seq1;
+        Seq2 seq2;
+        Less less;
+        const value_type *h1, *h2;
+        bool advance1, advance2;
+
+        const value_type * emit(const value_type * item, bool a1, bool a2)
+        {
+            advance1 = a1;
+            advance2 = a2;
+            return item;
+        }
+
+        const value_type * seek1(const value_type & value)
+        {
+            return detail::seek(seq1, h1, value, less, helpers::is_seekable<Seq1>());
+        }
+
+        const value_type * seek2(const value_type & value)
+        {
+            return detail::seek(seq2, h2, value, less, helpers::is_seekable<Seq2>());
+        }
+
+        // Finds the next element to emit, leaving h1 and h2 at the current heads
+        const value_type * find()
+        {
+            switch(Op)
+            {
+            case set_operation::union_of:
+                if(!h1) return emit(h2, false, true);
+                if(!h2) return emit(h1, true, false);
+                if(less(*h1, *h2)) return emit(h1, true, false);
+                if(less(*h2, *h1)) return emit(h2, false, true);
+                return emit(h1, true, true);
+
+            case set_operation::intersection:
+                while(h1 && h2)
+                {
+                    if(less(*h1, *h2))
+                        h1 = seek1(*h2);
+                    else if(less(*h2, *h1))
+                        h2 = seek2(*h1);
+                    else
+                        return emit(h1, true, true);
+                }
+                return nullptr;
+
+            case set_operation::difference:
+                while(h1)
+                {
+                    if(!h2 || less(*h1, *h2)) return emit(h1, true, false);
+                    if(less(*h2, *h1))
+                        h2 = seek2(*h1);
+                    else
+                    {
+                        h1 = seq1.next();
+                        h2 = seq2.next();
+                    }
+                }
+                return nullptr;
+
+            case set_operation::symmetric_difference:
+                for(;;)
+                {
+                    if(!h1) return emit(h2, false, true);
+                    if(!h2) return emit(h1, true, false);
+                    if(less(*h1, *h2)) return emit(h1, true, false);
+                    if(less(*h2, *h1)) return emit(h2, false, true);
+                    h1 = seq1.next();
+                    h2 = seq2.next();
+                }
+            }
+            return nullptr;
+        }
+    };
+}
@@ -0,0 +1,333 @@
+// Implements the kernels used for block evaluation and for searching.
+// Kernels are written as simple loops that the compiler can vectorize,
+// and use AVX2 intrinsics when the compiler targets AVX2.
+// The byte search kernels also select AVX2 at run time unless SEQUENCE_CPU_DISPATCH is 0.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // An unsigned integer of the same width as T, used for selection masks.
+        // A mask lane is all ones if the element is selected, and zero otherwise.
+        template<typename T>
+        struct lane_mask
+        {
+            typedef typename std::conditional<sizeof(T)==1, std::uint8_t,
+                typename std::conditional<sizeof(T)==2, std::uint16_t,
+                typename std::conditional<sizeof(T)==4, std::uint32_t, std::uint64_t>::type>::type>::type type;
+        };
+
+        // Calls fn(i) for each lane of a block of n elements.
+        // Full blocks use a constant trip count, which compilers vectorize more readily.
+        template<typename Fn>
+        void for_each_lane(std::size_t n, Fn fn)
+        {
+            if(n == helpers::block_size)
+                for(std::size_t i=0; i<helpers::block_size; ++i) fn(i);
+            else
+                for(std::size_t i=0; i<n; ++i) fn(i);
+        }
+
+        // Computes the selection mask of a block
+        template<typename T, typename Predicate>
+        void select_mask(const T * block, std::size_t n, Predicate & pred, typename lane_mask<T>::type * mask)
+        {
+            typedef typename lane_mask<T>::type mask_type;
+            for_each_lane(n, [&](std::size_t i) { mask[i] = mask_type(0) - mask_type(pred(block[i]) ? 1 : 0); });
+        }
+
+        // Converts a selection mask to the lane width of type To
+        template<typename To, typename From>
+        void convert_mask(const From * mask, std::size_t n, typename lane_mask<To>::type * output)
+        {
+            typedef typename lane_mask<To>::type mask_type;
+            for_each_lane(n, [&](std::size_t i) { output[i] = mask_type(0) - mask_type(mask[i] & 1); });
+        }
+
+        // Returns the element if it is selected, and zero otherwise
+        template<typename T>
+        typename std::enable_if<std::is_integral<T>::value, T>::type masked(T item, typename lane_mask<T>::type mask)
+        {
+            return T(typename lane_mask<T>::type(item) & mask);
+        }
+
+        template<typename T>
+        typename std::enable_if<!std::is_integral<T>::value, T>::type masked(T item, typename lane_mask<T>::type mask)
+        {
+            return mask ? item : T();
+        }
+
+        // Copies the selected elements of block to output, which can be the same as block.
+        // Returns the number of elements copied.
+        template<typename T>
+        std::size_t compact_scalar(const T * block, std::size_t n, const typename lane_mask<T>::type * mask, T * output)
+        {
+            std::size_t count = 0;
+            for(std::size_t i=0; i<n; ++i)
+            {
+                output[count] = block[i];
+                count += mask[i] & 1;
+            }
+            return count;
+        }
+
+#if defined(__AVX2__)
+        // Permutes the selected lanes of a vector to the front,
+        // using a table of 32-bit lane indices for each mask
+        template<std::size_t Size>
+        struct compact_table
+        {
+            static const int lanes = 32/Size;
+            std::int32_t indices[1<<lanes][8];
+
+            compact_table()
+            {
+                const int words = Size/4;
+                for(int mask=0; mask < (1<<lanes); ++mask)
+                {
+                    int k = 0;
+                    for(int lane=0; lane<lanes; ++lane)
+                        if(mask>>lane & 1)
+                            for(int w=0; w<words; ++w)
+                                indices[mask][k++] = lane*words + w;
+                    while(k<8)
+                    {
+                        indices[mask][k] = k;
+                        ++k;
+                    }
+                }
+            }
+
+            static const compact_table & get()
+            {
+                static const compact_table table;
+                return table;
+            }
+        };
+
+        inline int sign_mask(__m256i mask, std::integral_constant<std::size_t, 4>)
+        {
+            return _mm256_movemask_ps(_mm256_castsi256_ps(mask));
+        }
+
+        inline int sign_mask(__m256i mask, std::integral_constant<std::size_t, 8>)
+        {
+            return _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+        }
+
+        // Stores one vector of selected lanes at a time. Each store writes a whole vector,
+        // which only overwrites lanes that have already been read.
+        template<typename T>
+        typename std::enable_if<sizeof(T)==4 || sizeof(T)==8, std::size_t>::type
+        compact(const T * block, std::size_t n, const typename lane_mask<T>::type * mask, T * output)
+        {
+            typedef compact_table<sizeof(T)> table;
+            auto & indices = table::get().indices;
+            std::size_t count = 0, i = 0;
+            for(; i + table::lanes <= n; i += table::lanes)
+            {
+                int bits = sign_mask(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask+i)), std::integral_constant<std::size_t, sizeof(T)>());
+                __m256i items = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block+i));
+                __m256i selected = _mm256_permutevar8x32_epi32(items, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices[bits])));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(output+count), selected);
+                // Population count of up to 8 bits
+                count += ((0x4332322132212110ull >> ((bits & 15)*4)) & 15) + ((0x4332322132212110ull >> ((bits >> 4)*4)) & 15);
+            }
+            return count + compact_scalar(block+i, n-i, mask+i, output+count);
+        }
+
+        template<typename T>
+        typename std::enable_if<sizeof(T)!=4 && sizeof(T)!=8, std::size_t>::type
+        compact(const T * block, std::size_t n, const typename lane_mask<T>::type * mask, T * output)
+        {
+            return compact_scalar(block, n, mask, output);
+        }
+#else
+        template<typename T>
+        std::size_t compact(const T * block, std::size_t n, const typename lane_mask<T>::type * mask, T * output)
+        {
+            return compact_scalar(block, n, mask, output);
+        }
+#endif
+
+        // Whether the AVX2 search kernels can be used
+        inline bool has_avx2()
+        {
+#if defined(__AVX2__)
+            return true;
+#elif SEQUENCE_CPU_DISPATCH
+            static const bool result = __builtin_cpu_supports("avx2");
+            return result;
+#else
+            return false;
+#endif
+        }
+
+        // Whether the SSE4.2 CRC32C instructions can be used
+        inline bool has_sse42()
+        {
+#if defined(__SSE4_2__)
+            return true;
+#elif SEQUENCE_CPU_DISPATCH
+            static const bool result = __builtin_cpu_supports("sse4.2");
+            return result;
+#else
+            return false;
+#endif
+        }
+
+        inline std::size_t count_byte_scalar(const unsigned char * begin, const unsigned char * end, unsigned char value)
+        {
+            std::size_t count = 0;
+            for(; begin!=end; ++begin)
+                count += *begin==value;
+            return count;
+        }
+
+        // A set of bytes, stored as a table for scalar searches and a list for AVX2 searches
+        struct byte_set
+        {
+            bool contains[256];
+            unsigned char bytes[256];
+            std::size_t size;
+
+            template<typename Seq>
+            explicit byte_set(const Seq & seq) : contains(), size(0)
+            {
+                for(auto & item : seq)
+                {
+                    unsigned char byte = (unsigned char)item;
+                    if(!contains[byte]) bytes[size++] = byte;
+                    contains[byte] = true;
+                }
+            }
+        };
+
+        inline const unsigned char * find_first_of_scalar(const unsigned char * begin, const unsigned char * end, const byte_set & set)
+        {
+            while(begin!=end && !set.contains[*begin]) ++begin;
+            return begin;
+        }
+
+#if defined(__AVX2__) || SEQUENCE_CPU_DISPATCH
+        // 32 bytes, using vector extensions instead of intrinsics so that <immintrin.h> is not needed.
+        // The kernels are compiled for AVX2 using target attributes.
+        typedef char byte_vector __attribute__((vector_size(32)));
+        typedef std::uint64_t word_vector __attribute__((vector_size(32)));
+
+        // Counts bytes 32 at a time, using bytewise counters that are summed before they can overflow
+#if !defined(__AVX2__)
+        __attribute__((target("avx2")))
+#endif
+        inline std::size_t count_byte_avx2(const unsigned char * begin, const unsigned char * end, unsigned char value)
+        {
+            byte_vector needle;
+            for(int i=0; i<32; ++i) needle[i] = (char)value;
+            std::size_t count = 0;
+            while(end-begin >= 32)
+            {
+                std::size_t vectors = std::min<std::size_t>((end-begin)/32, 255);
+                byte_vector counters = needle ^ needle;
+                for(std::size_t i=0; i<vectors; ++i, begin+=32)
+                {
+                    byte_vector items;
+                    std::memcpy(&items, begin, 32);
+                    counters -= (byte_vector)(items == needle);
+                }
+                for(int i=0; i<32; ++i)
+                    count += (unsigned char)counters[i];
+            }
+            return count + count_byte_scalar(begin, end, value);
+        }
+
+        // Compares 32 bytes at a time with each byte in a small set
+#if !defined(__AVX2__)
+        __attribute__((target("avx2")))
+#endif
+        inline const unsigned char * find_first_of_avx2(const unsigned char * begin, const unsigned char * end, const byte_set & set)
+        {
+            byte_vector needles[8];
+            for(std::size_t i=0; i<set.size; ++i)
+                for(int j=0; j<32; ++j) needles[i][j] = (char)set.bytes[i];
+
+            for(; end-begin >= 32; begin += 32)
+            {
+                byte_vector items;
+                std::memcpy(&items, begin, 32);
+                byte_vector found = (byte_vector)(items == needles[0]);
+                for(std::size_t i=1; i<set.size; ++i)
+                    found |= (byte_vector)(items == needles[i]);
+                // The first matching byte is the lowest nonzero byte, on little-endian x86
+                word_vector words = (word_vector)found;
+                for(int i=0; i<4; ++i)
+                    if(words[i]) return begin + 8*i + __builtin_ctzll(words[i])/8;
+            }
+            return find_first_of_scalar(begin, end, set);
+        }
+#endif
+
+        // Counts the bytes equal to value
+        inline std::size_t count_byte(const unsigned char * begin, const unsigned char * end, unsigned char value)
+        {
+#if defined(__AVX2__) || SEQUENCE_CPU_DISPATCH
+            if(has_avx2()) return count_byte_avx2(begin, end, value);
+#endif
+            return count_byte_scalar(begin, end, value);
+        }
+
+        // Finds the first byte in the set, or end
+        inline const unsigned char * find_first_of_bytes(const unsigned char * begin, const unsigned char * end, const byte_set & set)
+        {
+            if(set.size == 0 || begin == end) return end;
+            if(set.size == 1)
+            {
+                auto found = std::memchr(begin, set.bytes[0], end-begin);
+                return found ? static_cast<const unsigned char*>(found) : end;
+            }
+#if defined(__AVX2__) || SEQUENCE_CPU_DISPATCH
+            if(set.size <= 8 && has_avx2()) return find_first_of_avx2(begin, end, set);
+#endif
+            return find_first_of_scalar(begin, end, set);
+        }
+
+        // Searches contiguous elements, using the byte kernels for bytes
+        template<typename T>
+        const T * find_value(const T * begin, const T * end, const T & value, std::true_type)
+        {
+            if(begin == end) return end;
+            auto found = std::memchr(begin, (unsigned char)value, end-begin);
+            return found ? static_cast<const T*>(found) : end;
+        }
+
+        template<typename T>
+        const T * find_value(const T * begin, const T * end, const T & value, std::false_type)
+        {
+            return std::find(begin, end, value);
+        }
+
+        template<typename T>
+        std::size_t count_value(const T * begin, const T * end, const T & value, std::true_type)
+        {
+            return count_byte(reinterpret_cast<const unsigned char*>(begin), reinterpret_cast<const unsigned char*>(end), (unsigned char)value);
+        }
+
+        template<typename T>
+        std::size_t count_value(const T * begin, const T * end, const T & value, std::false_type)
+        {
+            return std::count(begin, end, value);
+        }
+
+        template<typename T, typename Set>
+        const T * find_first_of(const T * begin, const T * end, const Set & set, std::true_type)
+        {
+            auto u = reinterpret_cast<const unsigned char*>(begin);
+            return begin + (find_first_of_bytes(u, u + (end-begin), byte_set(set)) - u);
+        }
+
+        template<typename T, typename Set>
+        const T * find_first_of(const T * begin, const T * end, const Set & set, std::false_type)
+        {
+            return std::find_if(begin, end, [&](const T & item) { return set.contains(item); });
+        }
+    }
+}
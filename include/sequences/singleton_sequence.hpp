@@ -10,6 +10,12 @@ namespace sequences
         singleton_sequence(const T & v) : value(v) {}
         const value_type * first() { return &value; }
         const value_type * next() { return nullptr; }
+        typedef void is_reversible;
+        typedef void is_multipass;
+        typedef void is_forward;
+        typedef void is_sized;
+        const value_type * last() { return &value; }
+        const value_type * prev() { return nullptr; }
         std::size_t size() const { return 1; }
     };
 }
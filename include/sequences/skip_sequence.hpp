@@ -6,21 +6,38 @@ namespace sequences
     class skip_sequence : public base_sequence<T, skip_sequence<T,Seq>>
     {
         Seq seq;
-        int to_skip;
+        std::size_t to_skip, remaining;
     public:
-        skip_sequence(const Seq & u, int count) : seq(u), to_skip(count) {}
+        SEQUENCE_CONSTEXPR skip_sequence(const Seq & u, int count) : seq(u), to_skip(count>0 ? count : 0), remaining(0) {}
 
-        const T * first()
+        SEQUENCE_CONSTEXPR const T * first()
         {
             auto result = seq.first();
-            for(int i=0; result && i<to_skip; i++)
+            for(std::size_t i=0; result && i<to_skip; i++)
                 result = seq.next();
             return result;
         }
 
-        const T * next()
+        SEQUENCE_CONSTEXPR const T * next()
         {
             return seq.next();
         }
+
+        typedef typename std::conditional<helpers::is_reversible<Seq>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_multipass<Seq>::value, void, int>::type is_multipass;
+
+        // remaining counts down the number of elements left before the skipped ones
+        SEQUENCE_CONSTEXPR const T * last()
+        {
+            std::size_t size = seq.size();
+            remaining = size > to_skip ? size - to_skip : 0;
+            return remaining ? seq.last() : nullptr;
+        }
+
+        SEQUENCE_CONSTEXPR const T * prev()
+        {
+            return remaining && --remaining ? seq.prev() : nullptr;
+        }
     };
 }
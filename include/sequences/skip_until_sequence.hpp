@@ -11,6 +11,7 @@ namespace sequences
         skip_until_sequence(const Seq & s, Predicate p) : seq(s), predicate(p) {}
 
         typedef typename Seq::value_type value_type;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
 
         const value_type * first()
         {
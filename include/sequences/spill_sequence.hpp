@@ -0,0 +1,227 @@
+// Implements a sequence that caches another sequence in memory and on disk.
+
+namespace sequences
+{
+    // Evaluates the underlying sequence at most once, keeping the first elements
+    // in memory and writing the remainder to a file, so that the sequence
+    // can be iterated many times even if it is too large to fit in memory.
+    //
+    // Trivially copyable elements are stored on disk as raw blocks and are read back
+    // a block at a time, other elements are stored as records using serializer<T>.
+    //
+    // Copies of a spill_sequence share the same storage.
+    // Unlike cached_sequence, spill_sequence must not be iterated in multiple threads.
+    template<typename Seq>
+    class spill_sequence : public base_sequence<typename Seq::value_type, spill_sequence<Seq>>
+    {
+    public:
+        typedef typename Seq::value_type value_type;
+
+        spill_sequence(const Seq & seq, const char * path, std::size_t memory_budget) :
+            data(std::allocate_shared<store>(arena_allocator<store>(), seq, path, memory_budget)) {}
+
+        // Copies share the storage but not the iteration state
+        spill_sequence(const spill_sequence & other) : data(other.data) {}
+
+        const value_type * first()
+        {
+            position = 0;
+            current = data->hot.first_chunk();
+            index = 0;
+            input.seek(data->file, 0);
+            block_size = block_index = 0;
+            return fetch();
+        }
+
+        const value_type * next()
+        {
+            ++position;
+            return fetch();
+        }
+
+        // Evaluates the entire sequence
+        std::size_t size() const
+        {
+            data->fill();
+            return data->hot.size() + data->spilled;
+        }
+
+    private:
+        typedef serializer<value_type> serializer_type;
+
+        // Trivially copyable elements are read a block at a time
+        static const bool raw_blocks = std::is_trivially_copyable<value_type>::value;
+        static const std::size_t block_bytes = 1<<20;
+
+        struct store
+        {
+            store(const Seq & seq, const char * path, std::size_t memory_budget) :
+                seq(seq), started(false), complete(false), hot_bytes(0), memory_budget(memory_budget),
+                path(path ? path : ""), file(nullptr), spilled(0) {}
+
+            ~store()
+            {
+                if(file)
+                {
+                    std::fclose(file);
+                    if(!path.empty()) std::remove(path.c_str());
+                }
+            }
+
+            Seq seq;
+            bool started, complete;
+
+            // The elements held in memory
+            chunked_buffer<value_type> hot;
+            std::size_t hot_bytes, memory_budget;
+
+            // The elements held on disk
+            std::string path;
+            std::FILE * file;
+            binary_output output;
+            std::size_t spilled;
+
+            // Gets the next element from the underlying sequence
+            const value_type * pull()
+            {
+                if(complete) return nullptr;
+                const value_type * item = started ? seq.next() : seq.first();
+                started = true;
+                if(!item) complete = true;
+                return item;
+            }
+
+            // Evaluates the rest of the sequence
+            void fill()
+            {
+                while(auto item = pull()) add(*item);
+                output.flush();
+            }
+
+            // Stores an element, and returns a pointer to it if it is stored in memory
+            const value_type * add(const value_type & item)
+            {
+                if(!spilled && hot_bytes < memory_budget)
+                {
+                    hot_bytes += serializer_type::footprint(item);
+                    return hot.push_back(item);
+                }
+
+                if(!file)
+                {
+                    file = create_file();
+                    if(!file) throw std::runtime_error("spill() could not create a file, or the file already exists");
+                    output.open(file);
+                }
+                serializer_type::write(output, item);
+                ++spilled;
+                return nullptr;
+            }
+
+            // Creates the file, without overwriting an existing file.
+            // Files created in a directory are removed immediately, and are deleted when closed.
+            std::FILE * create_file()
+            {
+                if(path.empty()) return std::tmpfile();
+#if SEQUENCE_ENABLE_POSIX
+                struct stat info;
+                if(::stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+                {
+                    std::string name = path + "/spill-XXXXXX";
+                    int fd = ::mkstemp(&name[0]);
+                    if(fd < 0) return nullptr;
+                    ::unlink(name.c_str());
+                    path.clear();
+                    std::FILE * result = ::fdopen(fd, "w+b");
+                    if(!result) ::close(fd);
+                    return result;
+                }
+#endif
+                return std::fopen(path.c_str(), "w+bx");
+            }
+        };
+
+        std::shared_ptr<store> data;
+
+        // The position in the hot prefix
+        std::size_t position, index;
+        const typename chunked_buffer<value_type>::chunk * current;
+
+        // The position on disk
+        binary_input input;
+        value_type current_value;
+        detail::byte_buffer block;
+        std::size_t block_size, block_index;
+
+        const value_type * fetch()
+        {
+            std::size_t hot_size = data->hot.size();
+
+            if(position < hot_size)
+            {
+                if(!current) current = data->hot.first_chunk();
+                if(index == current->size)
+                {
+                    current = current->next;
+                    index = 0;
+                }
+                return current->items + index++;
+            }
+
+            if(position - hot_size < data->spilled)
+            {
+                // The file may have been created since the iteration started
+                if(!input.is_open()) input.seek(data->file, 0);
+                return read(std::integral_constant<bool, raw_blocks>());
+            }
+
+            // Extend the sequence from the underlying sequence
+            auto item = data->pull();
+            if(!item) return nullptr;
+
+            auto stored = data->add(*item);
+            if(stored)
+            {
+                if(!current) current = data->hot.first_chunk();
+                if(index == current->size)
+                {
+                    current = current->next;
+                    index = 0;
+                }
+                ++index;
+                return stored;
+            }
+
+            // Skip over the element on disk
+            input.seek(data->file, data->output.position());
+            block_size = block_index = 0;
+            current_value = *item;
+            return &current_value;
+        }
+
+        // Reads the next block of elements from disk
+        const value_type * read(std::true_type)
+        {
+            if(block_index == block_size)
+            {
+                data->output.flush();
+                if(!block) block.reset(block_bytes);
+                std::size_t n = std::min(block_bytes/sizeof(value_type), data->spilled - (position - data->hot.size()));
+                if(n == 0) n = 1;
+                block_size = input.read_block(block.get(), n*sizeof(value_type)) / sizeof(value_type);
+                block_index = 0;
+                if(block_size == 0) throw std::runtime_error("spill() could not read the file");
+            }
+            return reinterpret_cast<const value_type*>(block.get()) + block_index++;
+        }
+
+        // Reads the next record from disk
+        const value_type * read(std::false_type)
+        {
+            data->output.flush();
+            if(!serializer_type::read(input, current_value))
+                throw std::runtime_error("spill() could not read the file");
+            return &current_value;
+        }
+    };
+}
@@ -2,16 +2,18 @@
 
 namespace sequences
 {
-    template<typename Seq>
-    class split_sequence : public base_sequence<std::basic_string<typename Seq::value_type>, split_sequence<Seq>>
+    // Alloc is the allocator of the tokens, which defaults to std::allocator.
+    template<typename Seq, typename Alloc>
+    class split_sequence : public base_sequence<std::basic_string<typename Seq::value_type, std::char_traits<typename Seq::value_type>, Alloc>, split_sequence<Seq, Alloc>>
     {
         Seq seq;
         const typename Seq::value_type * splitChars;
         typedef typename Seq::value_type char_type;
     public:
-        typedef std::basic_string<typename Seq::value_type> value_type;
+        typedef std::basic_string<char_type, std::char_traits<char_type>, Alloc> value_type;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
 
-        split_sequence(const Seq & seq, const char_type * chs) : seq(seq), splitChars(chs) {}
+        split_sequence(const Seq & seq, const char_type * chs, const Alloc & alloc = Alloc()) : seq(seq), splitChars(chs), eof(false), token(alloc) {}
 
         bool eof;
         value_type token;
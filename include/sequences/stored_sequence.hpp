@@ -10,24 +10,69 @@ namespace sequences
         typedef typename Container::value_type value_type;
         typename Container::const_iterator current;
 
-        stored_sequence(Container && c) : container(std::move(c)) {}
+        SEQUENCE_CONSTEXPR stored_sequence(Container && c) : container(std::move(c)), current() {}
 
         // TODO: Do we want this?
         // Efficiency warning
         // stored_sequence(const stored_sequence & other) = delete;
 
-        const value_type * first()
+        SEQUENCE_CONSTEXPR const value_type * first()
         {
             current = container.begin();
             return current == container.end() ? nullptr : &*current;
         }
 
-        const value_type * next()
+        SEQUENCE_CONSTEXPR const value_type * next()
         {
             ++current;
             return current == container.end() ? nullptr : &*current;
         }
 
-        std::size_t size() const { return container.size(); }
+        typedef void is_multipass;
+        typedef void is_forward;
+        typedef void is_stable;
+        typedef void is_sized;
+        typedef typename std::conditional<helpers::has_data<Container>::value, void, int>::type is_contiguous;
+
+        SEQUENCE_CONSTEXPR const value_type * data() const { return container.data(); }
+
+        typedef typename std::conditional<helpers::is_bidirectional<typename Container::const_iterator>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_random_access<typename Container::const_iterator>::value, void, int>::type is_seekable;
+
+        // Advances to the first element that is not less than value
+        template<typename Less>
+        const value_type * seek(const value_type & value, Less & less)
+        {
+            current = helpers::gallop(current, container.cend(), value, less);
+            return current == container.end() ? nullptr : &*current;
+        }
+
+        SEQUENCE_CONSTEXPR const value_type * last()
+        {
+            current = container.end();
+            return prev();
+        }
+
+        SEQUENCE_CONSTEXPR const value_type * prev()
+        {
+            if(current == container.begin()) return nullptr;
+            --current;
+            return &*current;
+        }
+
+        SEQUENCE_CONSTEXPR std::size_t size() const { return container.size(); }
+
+        // The range of a stored sequence points into its container, so is valid while the sequence exists
+        template<typename D=stored_sequence>
+        auto range() const & -> decltype(std::declval<const base_sequence<value_type, D>&>().range())
+        {
+            return base_sequence<value_type, stored_sequence>::range();
+        }
+
+        // The range of a temporary sequence keeps the container, so gives forward iterators
+        forward_range<stored_sequence> range() &&
+        {
+            return forward_range<stored_sequence>(std::move(*this));
+        }
     };
 }
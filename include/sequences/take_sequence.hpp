@@ -6,19 +6,43 @@ namespace sequences
     class take_sequence : public base_sequence<T, take_sequence<T,Seq>>
     {
         Seq seq;
-        int to_take;
-        int index;
+        std::size_t to_take;
+        std::size_t index;
     public:
-        take_sequence(const Seq & u, int count) : seq(u), to_take(count) {}
+        SEQUENCE_CONSTEXPR take_sequence(const Seq & u, int count) : seq(u), to_take(count>0 ? count : 0), index(0) {}
 
-        const T * first()
+        SEQUENCE_CONSTEXPR const T * first()
         {
             return (index=0)<to_take ? seq.first() : nullptr;
         }
 
-        const T * next()
+        SEQUENCE_CONSTEXPR const T * next()
         {
             return (++index)<to_take ? seq.next() : nullptr;
         }
+
+        typedef typename std::conditional<helpers::is_reversible<Seq>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_multipass<Seq>::value, void, int>::type is_multipass;
+
+        // Walks back from the end of the underlying sequence to the last taken element.
+        // index counts down the number of elements remaining.
+        // If the underlying sequence is not sized, such as where(), size() walks the whole
+        // sequence and the walk back from the end walks it again.
+        SEQUENCE_CONSTEXPR const T * last()
+        {
+            std::size_t size = seq.size();
+            index = size < to_take ? size : to_take;
+            if(index==0) return nullptr;
+            auto result = seq.last();
+            for(std::size_t i=index; result && i<size; ++i)
+                result = seq.prev();
+            return result;
+        }
+
+        SEQUENCE_CONSTEXPR const T * prev()
+        {
+            return index && --index ? seq.prev() : nullptr;
+        }
     };
 }
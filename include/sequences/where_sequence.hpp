@@ -8,9 +8,9 @@ namespace sequences
         Seq seq;
         Predicate pred;
     public:
-        where_sequence(const Seq &seq, Predicate pred) : seq(seq), pred(pred) {}
+        SEQUENCE_CONSTEXPR where_sequence(const Seq &seq, Predicate pred) : seq(seq), pred(pred) {}
 
-        const T * first()
+        SEQUENCE_CONSTEXPR const T * first()
         {
             const T * result = seq.first();
             while(result && !pred(*result))
@@ -18,13 +18,91 @@ namespace sequences
             return result;
         }
 
-        const T * next()
+        SEQUENCE_CONSTEXPR const T * next()
         {
-            const T * result;
+            const T * result = nullptr;
             do
                 result = seq.next();
             while(result && !pred(*result));
             return result;
         }
+
+        typedef typename std::conditional<helpers::is_reversible<Seq>::value, void, int>::type is_reversible;
+        typedef typename std::conditional<helpers::is_forward<Seq>::value, void, int>::type is_forward;
+        typedef typename std::conditional<helpers::is_blockwise<Seq>::value && std::is_arithmetic<T>::value, void, int>::type is_blockwise;
+
+        const T * first_block(T * buffer, std::size_t & n)
+        {
+            std::size_t capacity = n;
+            auto block = seq.first_block(buffer, n);
+            return filter_block(block, buffer, n, capacity);
+        }
+
+        const T * next_block(T * buffer, std::size_t & n)
+        {
+            std::size_t capacity = n;
+            auto block = seq.next_block(buffer, n);
+            return filter_block(block, buffer, n, capacity);
+        }
+
+        // Blocks of the underlying sequence with the selection mask, which sum() and size()
+        // use directly, and which select() carries through
+        typedef is_blockwise is_masked;
+
+        const T * first_masked_block(T * buffer, typename detail::lane_mask<T>::type * mask, std::size_t & n)
+        {
+            auto block = seq.first_block(buffer, n);
+            detail::select_mask(block, n, pred, mask);
+            return block;
+        }
+
+        const T * next_masked_block(T * buffer, typename detail::lane_mask<T>::type * mask, std::size_t & n)
+        {
+            auto block = seq.next_block(buffer, n);
+            detail::select_mask(block, n, pred, mask);
+            return block;
+        }
+
+        SEQUENCE_CONSTEXPR const T * last()
+        {
+            const T * result = seq.last();
+            while(result && !pred(*result))
+                result = seq.prev();
+            return result;
+        }
+
+        SEQUENCE_CONSTEXPR const T * prev()
+        {
+            const T * result = nullptr;
+            do
+                result = seq.prev();
+            while(result && !pred(*result));
+            return result;
+        }
+
+    private:
+        typedef typename detail::lane_mask<T>::type mask_type;
+
+        // Compacts the matching elements into buffer, reading more blocks until
+        // at least one element matches or the underlying sequence ends.
+        // The predicate is evaluated for the whole block first, which the compiler can vectorize,
+        // and the elements are then compacted without branches.
+        const T * filter_block(const T * block, T * buffer, std::size_t & n, std::size_t capacity)
+        {
+            mask_type mask[helpers::block_size];
+            while(n)
+            {
+                detail::select_mask(block, n, pred, mask);
+                std::size_t count = detail::compact(block, n, mask, buffer);
+                if(count)
+                {
+                    n = count;
+                    break;
+                }
+                n = capacity;
+                block = seq.next_block(buffer, n);
+            }
+            return buffer;
+        }
     };
 }
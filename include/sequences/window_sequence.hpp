@@ -0,0 +1,300 @@
+// Implements sliding windows and rolling aggregates over a sequence.
+
+namespace sequences
+{
+    namespace detail
+    {
+        // A fixed-capacity circular buffer, which can be used as a deque.
+        template<typename T>
+        class ring_buffer
+        {
+        public:
+            explicit ring_buffer(std::size_t capacity) : storage(capacity*sizeof(T)), capacity(capacity), head(0), count(0) {}
+
+            ring_buffer(const ring_buffer & other) : ring_buffer(other.capacity) {}
+
+            ring_buffer & operator=(const ring_buffer&) = delete;
+
+            ~ring_buffer() { clear(); }
+
+            // Adds an item to the back of a buffer that is not full.
+            // Unlike push_back(), this does not need T to be assignable.
+            void append(const T & item)
+            {
+                new(items() + index(count++)) T(item);
+            }
+
+            // Adds an item to the back, replacing the front item if the buffer is full
+            void push_back(const T & item)
+            {
+                if(count < capacity)
+                    append(item);
+                else
+                {
+                    items()[head] = item;
+                    head = index(1);
+                }
+            }
+
+            void pop_front()
+            {
+                items()[head].~T();
+                head = index(1);
+                --count;
+            }
+
+            void pop_back()
+            {
+                items()[index(--count)].~T();
+            }
+
+            const T & front() const { return items()[head]; }
+
+            const T & back() const { return items()[index(count-1)]; }
+
+            std::size_t size() const { return count; }
+
+            bool empty() const { return count==0; }
+
+            bool full() const { return count==capacity; }
+
+            void clear()
+            {
+                while(count) pop_back();
+                head = 0;
+            }
+
+        private:
+            byte_buffer storage;
+            std::size_t capacity, head, count;
+
+            T * items() const { return reinterpret_cast<T*>(storage.get()); }
+
+            std::size_t index(std::size_t i) const
+            {
+                i += head;
+                return i >= capacity ? i - capacity : i;
+            }
+        };
+
+        // Maintains the sum of the last w elements
+        template<typename T>
+        class rolling_sum
+        {
+        public:
+            typedef T value_type;
+
+            explicit rolling_sum(std::size_t w) : items(w), total() {}
+
+            void clear()
+            {
+                items.clear();
+                total = T();
+            }
+
+            void push(const T & item)
+            {
+                if(items.full()) total -= items.front();
+                items.push_back(item);
+                total += item;
+            }
+
+            value_type value() const { return total; }
+
+        private:
+            ring_buffer<T> items;
+            T total;
+        };
+
+        // Maintains the mean of the last w elements.
+        // The mean of integers is a double.
+        template<typename T>
+        class rolling_mean
+        {
+        public:
+            typedef typename std::conditional<std::is_floating_point<T>::value, T, double>::type value_type;
+
+            explicit rolling_mean(std::size_t w) : sum(w), w(w) {}
+
+            void clear() { sum.clear(); }
+
+            void push(const T & item) { sum.push(item); }
+
+            value_type value() const { return value_type(sum.value()) / w; }
+
+        private:
+            rolling_sum<T> sum;
+            std::size_t w;
+        };
+
+        // Maintains the minimum (according to Less) of the last w elements,
+        // using a deque of candidates that is sorted by both position and value.
+        template<typename T, typename Less>
+        class rolling_extreme
+        {
+        public:
+            typedef T value_type;
+
+            explicit rolling_extreme(std::size_t w) : candidates(w), w(w), position(0) {}
+
+            void clear()
+            {
+                candidates.clear();
+                position = 0;
+            }
+
+            void push(const T & item)
+            {
+                // Remove candidates that can no longer be the extreme
+                while(!candidates.empty() && !less(candidates.back().first, item))
+                    candidates.pop_back();
+                if(!candidates.empty() && candidates.front().second + w <= position)
+                    candidates.pop_front();
+                candidates.push_back(std::make_pair(item, position++));
+            }
+
+            value_type value() const { return candidates.front().first; }
+
+        private:
+            ring_buffer<std::pair<T, std::size_t>> candidates;
+            std::size_t w, position;
+            Less less;
+        };
+    }
+
+    // Yields each window of w consecutive elements, starting every step elements.
+    // Windows are pointer_sequences into a buffer of 2*w elements, where each element
+    // is stored twice so that every window is contiguous. A window is only valid until
+    // the next window is requested. Incomplete windows at the end are not returned.
+    template<typename Seq>
+    class window_sequence : public base_sequence<pointer_sequence<typename Seq::value_type>, window_sequence<Seq>>
+    {
+    public:
+        typedef typename Seq::value_type element_type;
+        typedef pointer_sequence<element_type> value_type;
+
+        window_sequence(const Seq & seq, std::size_t w, std::size_t step) :
+            seq(seq), w(w), step(step), filled(0), position(0), view(nullptr, nullptr)
+        {
+            if(w==0 || step==0) throw std::invalid_argument("window() size and step must be positive");
+        }
+
+        // Copies do not copy the buffer
+        window_sequence(const window_sequence & other) :
+            seq(other.seq), w(other.w), step(other.step), filled(0), position(0), view(nullptr, nullptr) {}
+
+        window_sequence & operator=(const window_sequence&) = delete;
+
+        ~window_sequence()
+        {
+            for(std::size_t i=0; i<filled; ++i)
+            {
+                items()[i].~element_type();
+                items()[i+w].~element_type();
+            }
+        }
+
+        const value_type * first()
+        {
+            if(!storage) storage.reset(2*w*sizeof(element_type));
+            position = 0;
+
+            auto item = seq.first();
+            for(std::size_t i=0; i<w; ++i)
+            {
+                if(!item) return nullptr;
+                push(*item);
+                if(i+1<w) item = seq.next();
+            }
+            return current();
+        }
+
+        const value_type * next()
+        {
+            for(std::size_t i=0; i<step; ++i)
+            {
+                auto item = seq.next();
+                if(!item) return nullptr;
+                push(*item);
+            }
+            return current();
+        }
+
+    private:
+        Seq seq;
+        // The number of slots that hold elements, and the slot for the next element
+        std::size_t w, step, filled, position;
+        detail::byte_buffer storage;
+        value_type view;
+
+        element_type * items() const { return reinterpret_cast<element_type*>(storage.get()); }
+
+        // Stores the item at position and position+w
+        void push(const element_type & item)
+        {
+            if(position < filled)
+            {
+                items()[position] = item;
+                items()[position + w] = item;
+            }
+            else
+            {
+                new(items() + position) element_type(item);
+                new(items() + position + w) element_type(item);
+                ++filled;
+            }
+            if(++position == w) position = 0;
+        }
+
+        const value_type * current()
+        {
+            view = value_type(items() + position, items() + position + w);
+            return &view;
+        }
+    };
+
+    // Yields an aggregate of each window of w consecutive elements,
+    // updating the aggregate in O(1) amortized time per element.
+    template<typename Seq, typename Op>
+    class rolling_sequence : public base_sequence<typename Op::value_type, rolling_sequence<Seq, Op>>
+    {
+    public:
+        typedef typename Op::value_type value_type;
+
+        rolling_sequence(const Seq & seq, std::size_t w) : seq(seq), op(w), w(w)
+        {
+            if(w==0) throw std::invalid_argument("Rolling window size must be positive");
+        }
+
+        const value_type * first()
+        {
+            op.clear();
+            std::size_t count = 0;
+            for(auto item = seq.first(); item; item = seq.next())
+            {
+                op.push(*item);
+                if(++count == w)
+                {
+                    current = op.value();
+                    return &current;
+                }
+            }
+            return nullptr;
+        }
+
+        const value_type * next()
+        {
+            auto item = seq.next();
+            if(!item) return nullptr;
+            op.push(*item);
+            current = op.value();
+            return &current;
+        }
+
+    private:
+        Seq seq;
+        Op op;
+        std::size_t w;
+        value_type current;
+    };
+}
@@ -0,0 +1,43 @@
+// Implements a sequence that zips any number of sequences into a sequence of tuples.
+
+namespace sequences
+{
+    // Iterates several sequences in step, yielding a tuple of their elements.
+    // The sequence ends when any of the sequences ends.
+    template<typename... Seqs>
+    class zip_sequence : public base_sequence<std::tuple<typename Seqs::value_type...>, zip_sequence<Seqs...>>
+    {
+        std::tuple<Seqs...> seqs;
+    public:
+        typedef std::tuple<typename Seqs::value_type...> value_type;
+
+        zip_sequence(const Seqs&... seqs) : seqs(seqs...) {}
+
+        value_type current;
+
+        const value_type * first()
+        {
+            return advance(true, typename helpers::make_indices<sizeof...(Seqs)>::type());
+        }
+
+        const value_type * next()
+        {
+            return advance(false, typename helpers::make_indices<sizeof...(Seqs)>::type());
+        }
+
+    private:
+        template<std::size_t... I>
+        const value_type * advance(bool start, helpers::indices<I...>)
+        {
+            // Braced initializers are evaluated from left to right
+            std::tuple<const typename Seqs::value_type*...> items { (start ? std::get<I>(seqs).first() : std::get<I>(seqs).next())... };
+
+            bool found[] = { true, std::get<I>(items)!=nullptr... };
+            for(bool f : found)
+                if(!f) return nullptr;
+
+            current = value_type(*std::get<I>(items)...);
+            return &current;
+        }
+    };
+}
@@ -3,11 +3,15 @@
 
 int main()
 {
+    // cached() stores the primes as they are found, so they are only computed once.
     auto primes = seq(2,1000000).where([](int n) {
         return !seq(2,n-1).any([=](int m) { return n%m==0; });
-    });
+    }).cached();
 
     for(int p : primes.take(100)) std::cout << p << std::endl;
 
+    // Reuses the primes computed above
+    std::cout << "Sum of the first 100 primes: " << primes.take(100).sum() << std::endl;
+
     return 0;
 }
@@ -47,11 +47,20 @@ int main()
     // merge(s,fn) merge two sequences, calling fn on each pair
     print(seq1.merge(seq(10,19), [](int a, int b) { return a+b; }));
 
+    // zip(s...) combines sequences into tuples
+    print(zip(seq1, seq(10,19)).select([](const std::tuple<int,int> & t) { return std::get<0>(t)*std::get<1>(t); }));
+
+    // merge_sorted(s...) merges sorted sequences
+    print(merge_sorted(list(1,4,7), list(2,5,8), list(3,6,9)));
+
     // Cast each element to a new type using as<T>()
     print(list(true, false).as<int>());
 
     // Repeat sequence a number of times
     print(list(1,2).repeat(3));
 
+    // Reverse a sequence
+    print(seq1.where([](int x) { return x%2==0; }).reverse());
+
     return 0;
 }
@@ -1,135 +1,853 @@
 // Benchmarking Sequence
 // This compares the performance of Sequence against hand-written code.
-// We also look at the overhead of using `sequence<T>&`, which uses
-// virtual function calls.
 //
-// Benchmark 1: This calculates the sum of the squares of all
-// even numbers between 0 and 1_000_000_000.
+// Each case applies one stage to one source, and sums the results. Every case is
+// measured against a hand-written loop over the same data (the baseline), and the
+// results of the two must agree. Cases are run at several sizes, with static dispatch
+// (the type of the pipeline is known) and with dynamic dispatch, where the source is
+// passed as `sequence<T>&`, which uses virtual function calls.
 //
-// Benchmark 2: This constructs a string consisting of 1000000 'a's.
+// Each case is warmed up, and is then timed over several trials. Each trial repeats the case
+// enough times to take at least a few milliseconds. The results are the median and
+// variance of the time per element, in nanoseconds, over the trials.
+//
+// Usage: benchmarks [options]
+//   --json            Write JSON instead of CSV
+//   --output FILE     Write the results to FILE instead of stdout
+//   --trials N        The number of trials of each case (default 7)
+//   --sizes A,B,...   The number of elements in each source (default 1000,100000,1000000)
+//   --filter TEXT     Only run cases whose name contains TEXT, for example "where/pointer"
+//   --label TEXT      Label the results, for example with a commit
+//   --compare FILE    Compare the ratios to the baseline with a previous CSV run,
+//                     and report cases that are more than 10% slower than the noise.
+//                     The exit code is 2 if any case has regressed.
+//
+// The `run_benchmarks` CMake target runs the suite, and compares it with the previous run.
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SEQUENCE_ENABLE_POSIX 1
+#endif
 
 #include <sequence.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <sstream>
+#include <vector>
 
-const int N=1000000000;
+// Sources
+// Each source creates a sequence, and passes it to a function object.
+// Each source also implements each(fn), which is the hand-written loop over
+// the same elements, where fn returns false to stop.
+// The marker is a unique element half way through the source.
 
-// This is the canonical C implementation of Benchmark 1.
-// This is the fastest implementation.
-int benchmark1a()
+// seq(0, n-1)
+struct range_source
 {
-    int sum=0;
-    for(int i=0; i<=N; i++)
-        if(i%2==0)
-            sum += i*i;
-    return sum;
-}
+    typedef std::int64_t value_type;
+    static const char * name() { return "range"; }
+
+    explicit range_source(std::size_t n) : n(n) {}
+
+    template<typename Fn>
+    void with(Fn fn) const { fn(seq(std::int64_t(0), n-1)); }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        for(std::int64_t i=0; i<n; ++i)
+            if(!fn(i)) return;
+    }
+
+    value_type marker() const { return n/2; }
+
+    std::int64_t n;
+};
 
-// This is a Sequence implementation of Benchmark 1.
-// It is somewhat slower than the C implementation even though
-// it is fully inlined. The compiler was not able to optimize this
-// as much as the C implementation, so it is around 3 times slower.
-int benchmark1b()
+// A generator of 0 to n-1, created using generator()
+struct generator_source : range_source
 {
-    return seq(0, N).
-        where([](int n) { return n%2==0; }).
-        select([](int n) { return n*n; }).
-        sum();
-}
+    static const char * name() { return "generator"; }
+
+    explicit generator_source(std::size_t n) : range_source(n) {}
+
+    template<typename Fn>
+    void with(Fn fn) const
+    {
+        auto n = this->n;
+        fn(generator([n](std::int64_t & i) { i = 0; return n > 0; }, [n](std::int64_t & i) { return ++i < n; }));
+    }
+};
+
+// The integers 0 to n-1 in an array
+struct pointer_source
+{
+    typedef std::int64_t value_type;
+    static const char * name() { return "pointer"; }
+
+    explicit pointer_source(std::size_t n) : data(n)
+    {
+        for(std::size_t i=0; i<n; ++i) data[i] = i;
+    }
+
+    template<typename Fn>
+    void with(Fn fn) const { fn(seq(data.data(), data.data() + data.size())); }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        for(auto p = data.data(), e = p + data.size(); p != e; ++p)
+            if(!fn(*p)) return;
+    }
+
+    value_type marker() const { return data.size()/2; }
+
+    std::vector<std::int64_t> data;
+};
+
+// The integers 0 to n-1 in a linked list, iterated using iterators
+struct iterator_source
+{
+    typedef std::int64_t value_type;
+    static const char * name() { return "iterator"; }
+
+    explicit iterator_source(std::size_t n) : size(n)
+    {
+        for(std::size_t i=0; i<n; ++i) data.push_back(i);
+    }
+
+    template<typename Fn>
+    void with(Fn fn) const { fn(seq(data)); }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        for(auto i : data)
+            if(!fn(i)) return;
+    }
+
+    value_type marker() const { return size/2; }
+
+    std::list<std::int64_t> data;
+    std::size_t size;
+};
+
+// The integers 0 to n-1 in a vector that is stored in the sequence.
+// This includes the cost of copying the vector into the pipeline.
+struct stored_source : pointer_source
+{
+    static const char * name() { return "stored"; }
+
+    explicit stored_source(std::size_t n) : pointer_source(n) {}
+
+    template<typename Fn>
+    void with(Fn fn) const { fn(seq(std::vector<std::int64_t>(data))); }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        auto copy = data;
+        for(auto i : copy)
+            if(!fn(i)) return;
+    }
+};
+
+// Words of text read from a std::istream
+struct istream_source
+{
+    typedef char value_type;
+    static const char * name() { return "istream"; }
+
+    explicit istream_source(std::size_t n) : text(n, ' ')
+    {
+        for(std::size_t i=0; i<n; ++i)
+            if(i%6) text[i] = 'a' + i%7;
+        if(n) text[n/2] = '#';
+    }
+
+    template<typename Fn>
+    void with(Fn fn) const
+    {
+        std::istringstream is(text);
+        fn(seq(is));
+    }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        std::istringstream is(text);
+        for(std::istreambuf_iterator<char> i(is), e; i != e; ++i)
+            if(!fn(*i)) return;
+    }
+
+    value_type marker() const { return '#'; }
 
-int processInts(const sequence<int> & items)
+    std::string text;
+};
+
+#if SEQUENCE_ENABLE_POSIX
+// The same text as istream_source in a temporary file, read using file_reader().
+// The baseline reads the file in the same size buffers on the consuming thread.
+struct file_source : istream_source
+{
+    static const char * name() { return "file"; }
+
+    explicit file_source(std::size_t n) : istream_source(n), path("benchmarks-input.tmp")
+    {
+        std::ofstream(path, std::ios::binary) << text;
+    }
+
+    ~file_source() { std::remove(path); }
+
+    template<typename Fn>
+    void with(Fn fn) const { fn(file_reader(path, buffer_size)); }
+
+    template<typename Fn>
+    void each(Fn fn) const
+    {
+        int fd = ::open(path, O_RDONLY);
+        std::vector<char> buffer(buffer_size);
+        for(ssize_t n; (n = ::read(fd, buffer.data(), buffer.size())) > 0; )
+            for(ssize_t i=0; i<n; ++i)
+                if(!fn(buffer[i])) { ::close(fd); return; }
+        ::close(fd);
+    }
+
+    static const std::size_t buffer_size = 1<<16;
+    const char * path;
+};
+#endif
+
+// Sums the elements, which are 64-bit or characters
+template<typename Seq>
+std::int64_t total(const Seq & s, std::true_type)
 {
-    return items.where([](int n) { return n%2==0; }).
-        select([](int n) { return n*n; }).
-        sum();
+    return s.sum();
 }
 
 template<typename Seq>
-int processInts2(Seq items)
+std::int64_t total(const Seq & s, std::false_type)
 {
-    return items.where([](int n) { return n%2==0; }).
-        select([](int n) { return n*n; }).
-        sum();
+    return s.accumulate(std::int64_t(0), [](std::int64_t & t, typename Seq::value_type x) { t += x; });
 }
 
-// This is the Sequence implementation of Benchmark 1, with the added
-// overhead of iterating the sequence using virtual function calls which
-// is around 10 times slower than the inline C implementation due to the
-// overhead of virtual function calls used internally.
-int benchmark1c()
+template<typename Seq>
+std::int64_t total(const Seq & s)
 {
-    return processInts(seq(0,N));
+    return total(s, std::is_same<typename Seq::value_type, std::int64_t>());
 }
 
-// This is the Sequence implementation of Benchmark 1, using a templated
-// function to process the list. This shows the potential speedup of using templates
-// if you don't mind all your code in header files.
-int benchmark1d()
+// Stages
+// Each stage implements run(seq, source), which applies the stage to the sequence and sums the result,
+// and baseline(source), which is a hand-written loop that computes the same result.
+// Stages that cannot be applied to a source return false from applies().
+
+struct stage
+{
+    template<typename Source>
+    static constexpr bool applies() { return true; }
+};
+
+// Stages that read the source more than once cannot be used with streams
+struct multipass_stage : stage
+{
+    template<typename Source>
+    static constexpr bool applies() { return !std::is_same<Source, istream_source>::value; }
+};
+
+struct where_stage : stage
+{
+    static const char * name() { return "where"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        typedef typename Seq::value_type T;
+        return total(s.where([](T x) { return x%3==0; }));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        source.each([&](typename Source::value_type x) { if(x%3==0) sum += x; return true; });
+        return sum;
+    }
+};
+
+struct select_stage : stage
+{
+    static const char * name() { return "select"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        typedef typename Seq::value_type T;
+        return s.select([](T x) { return std::int64_t(x)*3+1; }).sum();
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        source.each([&](typename Source::value_type x) { sum += std::int64_t(x)*3+1; return true; });
+        return sum;
+    }
+};
+
+struct where_select_stage : stage
+{
+    static const char * name() { return "where_select"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        typedef typename Seq::value_type T;
+        return s.where([](T x) { return x%3==0; }).select([](T x) { return std::int64_t(x)*3+1; }).sum();
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        source.each([&](typename Source::value_type x) { if(x%3==0) sum += std::int64_t(x)*3+1; return true; });
+        return sum;
+    }
+};
+
+struct take_stage : stage
+{
+    static const char * name() { return "take"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source & source)
+    {
+        return total(s.take(int(source.marker())));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0, n = source.marker();
+        source.each([&](typename Source::value_type x) { if(n-- <= 0) return false; sum += x; return true; });
+        return sum;
+    }
+
+    // Characters do not give the element count
+    template<typename Source>
+    static constexpr bool applies() { return std::is_same<typename Source::value_type, std::int64_t>::value; }
+};
+
+struct skip_stage : take_stage
+{
+    static const char * name() { return "skip"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source & source)
+    {
+        return total(s.skip(int(source.marker())));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0, n = source.marker();
+        source.each([&](typename Source::value_type x) { if(n-- <= 0) sum += x; return true; });
+        return sum;
+    }
+};
+
+struct concat_stage : multipass_stage
+{
+    static const char * name() { return "concat"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        return total(s + s);
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        for(int i=0; i<2; ++i)
+            source.each([&](typename Source::value_type x) { sum += x; return true; });
+        return sum;
+    }
+};
+
+// Merges the elements with their positions
+struct merge_stage : stage
+{
+    static const char * name() { return "merge"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        typedef typename Seq::value_type T;
+        return s.merge(seq(std::int64_t(1), std::numeric_limits<std::int64_t>::max()), [](T x, std::int64_t i) { return x*i; }).sum();
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0, i = 0;
+        source.each([&](typename Source::value_type x) { sum += x * ++i; return true; });
+        return sum;
+    }
+};
+
+struct repeat_stage : multipass_stage
+{
+    static const char * name() { return "repeat"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        return total(s.repeat(3));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        for(int i=0; i<3; ++i)
+            source.each([&](typename Source::value_type x) { sum += x; return true; });
+        return sum;
+    }
+};
+
+// Counts the words in text
+struct split_stage : stage
+{
+    static const char * name() { return "split"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        return s.split(" ").size();
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t words = 0;
+        bool in_word = false;
+        source.each([&](char ch) { if(ch!=' ' && !in_word) ++words; in_word = ch!=' '; return true; });
+        return words;
+    }
+
+    template<typename Source>
+    static constexpr bool applies() { return std::is_same<typename Source::value_type, char>::value; }
+};
+
+struct take_while_stage : stage
+{
+    static const char * name() { return "take_while"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source & source)
+    {
+        typedef typename Seq::value_type T;
+        auto m = source.marker();
+        return total(s.take_while([m](T x) { return x != m; }));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        auto m = source.marker();
+        source.each([&](typename Source::value_type x) { if(x == m) return false; sum += x; return true; });
+        return sum;
+    }
+};
+
+struct skip_until_stage : stage
+{
+    static const char * name() { return "skip_until"; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source & source)
+    {
+        typedef typename Seq::value_type T;
+        auto m = source.marker();
+        return total(s.skip_until([m](T x) { return x == m; }));
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        bool found = false;
+        auto m = source.marker();
+        source.each([&](typename Source::value_type x) { if(x == m) found = true; if(found) sum += x; return true; });
+        return sum;
+    }
+};
+
+// Looks up each element at a pseudo-random position in a table that is larger than the cache.
+// The sequence prefetches the table ahead of the lookups, but the baseline does not.
+struct gather_stage : stage
+{
+    static const char * name() { return "gather"; }
+
+    static std::vector<std::int64_t> make_table()
+    {
+        std::vector<std::int64_t> t(1<<22);
+        for(std::size_t i=0; i<t.size(); ++i) t[i] = i & 0xff;
+        return t;
+    }
+
+    static const std::vector<std::int64_t> & table()
+    {
+        static const std::vector<std::int64_t> t = make_table();
+        return t;
+    }
+
+    static std::size_t index(std::int64_t x) { return (std::uint64_t(x) * 0x9E3779B97F4A7C15ull) >> 42; }
+
+    template<typename Seq, typename Source>
+    static std::int64_t run(const Seq & s, const Source &)
+    {
+        return gather(s.select(index), table().data(), 16).sum();
+    }
+
+    template<typename Source>
+    static std::int64_t baseline(const Source & source)
+    {
+        std::int64_t sum = 0;
+        auto & t = table();
+        source.each([&](std::int64_t x) { sum += t[index(x)]; return true; });
+        return sum;
+    }
+
+    template<typename Source>
+    static constexpr bool applies() { return std::is_same<typename Source::value_type, std::int64_t>::value; }
+};
+
+// Dispatch
+
+// Runs a stage on the sequence directly
+template<typename Stage, typename Source>
+struct static_dispatch
+{
+    static const char * name() { return "static"; }
+
+    const Source & source;
+    std::int64_t & result;
+
+    template<typename Seq>
+    void operator()(const Seq & s) const { result = Stage::run(s, source); }
+};
+
+// Runs a stage on the sequence, passed as sequence<T>&
+template<typename Stage, typename Source>
+struct dynamic_dispatch
+{
+    static const char * name() { return "dynamic"; }
+
+    const Source & source;
+    std::int64_t & result;
+
+    template<typename Seq>
+    void operator()(const Seq & s) const { run(s); }
+
+    // Not inlined, so that the compiler cannot see the type of the sequence
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    void run(const sequence<typename Source::value_type> & s) const { result = Stage::run(s, source); }
+};
+
+// Measurement
+
+struct options
+{
+    bool json = false;
+    int trials = 7;
+    std::vector<std::size_t> sizes = { 1000, 100000, 1000000 };
+    std::string filter, label, output, compare;
+};
+
+// The median and variance of the trials
+struct measurement
+{
+    double median = 0, variance = 0;
+
+    explicit measurement(std::vector<double> values)
+    {
+        if(values.empty()) return;
+        std::sort(values.begin(), values.end());
+        auto n = values.size();
+        median = n%2 ? values[n/2] : (values[n/2-1] + values[n/2]) / 2;
+        double mean = 0;
+        for(auto v : values) mean += v;
+        mean /= n;
+        for(auto v : values) variance += (v-mean) * (v-mean);
+        if(n > 1) variance /= n-1;
+    }
+};
+
+// Prevents the compiler from removing the computation of a result
+volatile std::int64_t sink;
+
+// Times a function, which is repeated so that it is long enough to time accurately
+template<typename Fn>
+class timer
+{
+public:
+    timer(Fn fn, std::size_t elements) : fn(fn), elements(std::max<std::size_t>(elements, 1)), repetitions(1)
+    {
+        // Warm up, and find the number of repetitions that takes at least 10ms
+        const double min_trial = 0.01;
+        for(double t; (t = seconds()) < min_trial; )
+            repetitions = t > 0 ? std::size_t(repetitions * std::min(100.0, 1.2 * min_trial / t)) + 1 : repetitions * 10;
+    }
+
+    // Runs a trial, returning the time per element in nanoseconds
+    double trial() { return seconds() * 1e9 / repetitions / elements; }
+
+private:
+    Fn fn;
+    std::size_t elements, repetitions;
+
+    double seconds()
+    {
+        auto start = std::chrono::steady_clock::now();
+        for(std::size_t i=0; i<repetitions; ++i)
+            sink = fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+template<typename Fn>
+timer<Fn> make_timer(Fn fn, std::size_t elements) { return timer<Fn>(fn, elements); }
+
+struct result
+{
+    std::string stage, source, dispatch, label;
+    std::size_t size;
+
+    // The time per element in nanoseconds, and the ratio of the time to the baseline
+    measurement sequence, baseline, ratio;
+
+    std::string name() const { return stage + "/" + source + "/" + dispatch + "/" + std::to_string(size); }
+};
+
+template<typename Stage, typename Source, template<typename, typename> class Dispatch>
+void run_case(const options &, std::size_t, std::vector<result> &, std::false_type)
 {
-    return processInts2(seq(0,N));
 }
 
-const int N2 = 1000000;
+template<typename Stage, typename Source, template<typename, typename> class Dispatch>
+void run_case(const options & opts, std::size_t size, std::vector<result> & results, std::true_type)
+{
+    typedef Dispatch<Stage, Source> dispatch;
+    std::string name = std::string(Stage::name()) + "/" + Source::name() + "/" + dispatch::name() + "/" + std::to_string(size);
+    if(name.find(opts.filter) == std::string::npos) return;
+
+    Source source(size);
+    std::int64_t actual = 0, expected = Stage::baseline(source);
+    source.with(dispatch{source, actual});
+    if(actual != expected)
+    {
+        std::cerr << name << ": result " << actual << " does not match the baseline " << expected << std::endl;
+        std::exit(1);
+    }
+
+    // Streams and the stored vector are created inside the timed code, for both implementations.
+    // Trials alternate between the implementations, so that changes in the speed of the
+    // machine affect both of them, and the ratio is stable.
+    auto sequence_timer = make_timer([&] { std::int64_t r; source.with(dispatch{source, r}); return r; }, size);
+    auto baseline_timer = make_timer([&] { return Stage::baseline(source); }, size);
+    std::vector<double> sequence_times, baseline_times, ratios;
+    for(int i=0; i<opts.trials; ++i)
+    {
+        sequence_times.push_back(sequence_timer.trial());
+        baseline_times.push_back(baseline_timer.trial());
+        ratios.push_back(sequence_times.back() / baseline_times.back());
+    }
+
+    results.push_back(result{Stage::name(), Source::name(), dispatch::name(), opts.label, size,
+        measurement(sequence_times), measurement(baseline_times), measurement(ratios)});
+    std::cerr << name << ": " << results.back().sequence.median << " ns/element, baseline " << results.back().baseline.median << " ns/element" << std::endl;
+}
 
-// This is the C implementation of Benchmark 2.
-// It is the joint-fastest implementation.
-int aloop1()
+template<typename Stage, typename Source>
+void run_dispatches(const options & opts, std::size_t size, std::vector<result> & results)
 {
-    std::string result;
-    for(int i=0; i<N2; ++i)
-        result += 'a';
-    return (int)result.size();
+    std::integral_constant<bool, Stage::template applies<Source>()> applies;
+    run_case<Stage, Source, static_dispatch>(opts, size, results, applies);
+    run_case<Stage, Source, dynamic_dispatch>(opts, size, results, applies);
 }
 
-// This is the Sequence implementation of Benchmark 2.
-// It is joint-fastest with the C implementation.
-// It uses `accumulate()` which is faster than `aggregate` in this case.
-int aloop2()
+template<typename Stage>
+void run_sources(const options & opts, std::size_t size, std::vector<result> & results)
 {
-    return (int)list('a').repeat(N2).accumulate(std::string(), [](std::string & str, char ch) { str+=ch; }).size();
+    run_dispatches<Stage, range_source>(opts, size, results);
+    run_dispatches<Stage, generator_source>(opts, size, results);
+    run_dispatches<Stage, pointer_source>(opts, size, results);
+    run_dispatches<Stage, iterator_source>(opts, size, results);
+    run_dispatches<Stage, stored_source>(opts, size, results);
+    run_dispatches<Stage, istream_source>(opts, size, results);
+#if SEQUENCE_ENABLE_POSIX
+    run_dispatches<Stage, file_source>(opts, size, results);
+#endif
 }
 
-// This is the Sequence implementation of Benchmark 2.
-// It uses `aggregate` which is significantly slower than `accumulate` in this case.
-int aloop3()
+std::vector<result> run_all(const options & opts)
 {
-    return (int)list('a').repeat(N2).aggregate(std::string(), [](const std::string & str, char ch) { return str+ch; }).size();
+    std::vector<result> results;
+    for(auto size : opts.sizes)
+    {
+        run_sources<where_stage>(opts, size, results);
+        run_sources<select_stage>(opts, size, results);
+        run_sources<where_select_stage>(opts, size, results);
+        run_sources<take_stage>(opts, size, results);
+        run_sources<skip_stage>(opts, size, results);
+        run_sources<concat_stage>(opts, size, results);
+        run_sources<merge_stage>(opts, size, results);
+        run_sources<repeat_stage>(opts, size, results);
+        run_sources<split_stage>(opts, size, results);
+        run_sources<take_while_stage>(opts, size, results);
+        run_sources<skip_until_stage>(opts, size, results);
+        run_sources<gather_stage>(opts, size, results);
+    }
+    return results;
 }
 
-int processAs(const sequence<char> & items)
+// Output
+
+const char * csv_header = "label,stage,source,dispatch,size,median_ns,variance_ns2,baseline_median_ns,baseline_variance_ns2,ratio,ratio_variance";
+
+void write_csv(std::ostream & os, const std::vector<result> & results)
 {
-    return (int)items.accumulate(std::string(), [](std::string & str, char ch) { str+=ch; }).size();
+    os << csv_header << "\n";
+    for(auto & r : results)
+        os << r.label << "," << r.stage << "," << r.source << "," << r.dispatch << "," << r.size << "," <<
+            r.sequence.median << "," << r.sequence.variance << "," <<
+            r.baseline.median << "," << r.baseline.variance << "," << r.ratio.median << "," << r.ratio.variance << "\n";
 }
 
-// This is a Sequence implementation of Benchmark 2, passing
-// the sequence as `sequence<char>&` which introduces virtual function calls.
-// This is around 13% slower than the inline version that does not use virtual function calls.
-int aloop4()
+void write_json(std::ostream & os, const std::vector<result> & results)
 {
-    return processAs(list('a').repeat(N2));
+    os << "[";
+    bool first = true;
+    for(auto & r : results)
+    {
+        os << (first ? "\n" : ",\n") << "  {\"label\": \"" << r.label << "\", \"stage\": \"" << r.stage <<
+            "\", \"source\": \"" << r.source << "\", \"dispatch\": \"" << r.dispatch << "\", \"size\": " << r.size <<
+            ", \"median_ns\": " << r.sequence.median << ", \"variance_ns2\": " << r.sequence.variance <<
+            ", \"baseline_median_ns\": " << r.baseline.median << ", \"baseline_variance_ns2\": " << r.baseline.variance <<
+            ", \"ratio\": " << r.ratio.median << ", \"ratio_variance\": " << r.ratio.variance << "}";
+        first = false;
+    }
+    os << "\n]\n";
 }
 
-template<typename Fn>
-void benchmark(Fn fn, const char * description)
+// Compares the ratios with a previous CSV run.
+// Ratios to the baseline are compared rather than times, so that runs on a busy
+// or different machine remain comparable. A case has regressed if its ratio is more than 10% higher,
+// and the difference is more than 3 standard deviations of the noise in the two runs.
+// Returns 2 if any case has regressed.
+int compare(const std::string & path, const std::vector<result> & results)
 {
-    auto t1 = std::chrono::high_resolution_clock::now();
-    int sum = fn();
-    auto t2 = std::chrono::high_resolution_clock::now();
-    std::cout << description << ", " << std::chrono::duration<double, std::milli>(t2-t1).count() << std::endl;
+    std::ifstream file(path);
+    if(!file)
+    {
+        std::cerr << "Could not open " << path << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, std::pair<double, double>> previous;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::vector<std::string> fields;
+        std::istringstream is(line);
+        for(std::string field; std::getline(is, field, ','); )
+            fields.push_back(field);
+        if(fields.size() != 11 || fields[1] == "stage") continue;
+        previous[fields[1] + "/" + fields[2] + "/" + fields[3] + "/" + fields[4]] = std::make_pair(std::atof(fields[9].c_str()), std::atof(fields[10].c_str()));
+    }
+
+    int regressions = 0;
+    for(auto & r : results)
+    {
+        auto p = previous.find(r.name());
+        if(p == previous.end()) continue;
+        double ratio = p->second.first, noise = 3 * std::sqrt(p->second.second + r.ratio.variance);
+        if(r.ratio.median > ratio * 1.1 && r.ratio.median - ratio > noise)
+        {
+            std::cerr << "REGRESSION " << r.name() << ": ratio " << ratio << " -> " << r.ratio.median << std::endl;
+            ++regressions;
+        }
+    }
+    std::cerr << regressions << " regressions compared with " << path << std::endl;
+    return regressions ? 2 : 0;
 }
 
-int main()
+int main(int argc, char ** argv)
 {
 #ifndef NDEBUG
-    std::cout << "WARNING!!! Running in a debug build\n";
+    std::cerr << "WARNING!!! Running in a debug build\n";
 #endif
-    benchmark(benchmark1a, "1a: C implementation");
-    benchmark(benchmark1b, "1b: Sequence implementation");
-    benchmark(benchmark1c, "1c: Sequence passed as reference");
-    benchmark(benchmark1d, "1d: Sequence passed as template");
-    benchmark(aloop1,      "2a: C implementation");
-    benchmark(aloop2,      "2b: Sequence implementation");
-    benchmark(aloop3,      "2c: Sequence using naive aggregate");
-    benchmark(aloop4,      "2d: Sequence passed as reference");
-    return 0;
+    options opts;
+    for(int i=1; i<argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool has_value = i+1 < argc;
+        if(arg == "--json")
+            opts.json = true;
+        else if(arg == "--trials" && has_value)
+            opts.trials = std::max(1, std::atoi(argv[++i]));
+        else if(arg == "--sizes" && has_value)
+        {
+            opts.sizes.clear();
+            std::istringstream is(argv[++i]);
+            for(std::string size; std::getline(is, size, ','); )
+                opts.sizes.push_back(std::strtoull(size.c_str(), nullptr, 10));
+        }
+        else if(arg == "--filter" && has_value)
+            opts.filter = argv[++i];
+        else if(arg == "--label" && has_value)
+            opts.label = argv[++i];
+        else if(arg == "--output" && has_value)
+            opts.output = argv[++i];
+        else if(arg == "--compare" && has_value)
+            opts.compare = argv[++i];
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json] [--output file] [--trials n] [--sizes a,b,c] [--filter text] [--label text] [--compare file]\n";
+            return 1;
+        }
+    }
+
+    auto results = run_all(opts);
+
+    std::ofstream file;
+    if(!opts.output.empty())
+    {
+        file.open(opts.output);
+        if(!file)
+        {
+            std::cerr << "Could not write " << opts.output << std::endl;
+            return 1;
+        }
+    }
+    std::ostream & os = opts.output.empty() ? std::cout : file;
+    if(opts.json)
+        write_json(os, results);
+    else
+        write_csv(os, results);
+
+    return opts.compare.empty() ? 0 : compare(opts.compare, results);
 }
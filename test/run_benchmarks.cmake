@@ -0,0 +1,32 @@
+# Runs the benchmarks, labelled with the current commit.
+# The results are written to benchmarks-<commit>.csv, and are compared with benchmarks-latest.csv from the previous run, which is then replaced.
+#
+# Usage: cmake -DBENCHMARKS=<path> -DSOURCE_DIR=<path> -DOUTPUT_DIR=<path> -P run_benchmarks.cmake
+
+execute_process(COMMAND git describe --always --dirty
+    WORKING_DIRECTORY ${SOURCE_DIR}
+    OUTPUT_VARIABLE COMMIT
+    OUTPUT_STRIP_TRAILING_WHITESPACE
+    ERROR_QUIET)
+if(NOT COMMIT)
+    set(COMMIT unknown)
+endif()
+
+set(CSV ${OUTPUT_DIR}/benchmarks-${COMMIT}.csv)
+set(LATEST ${OUTPUT_DIR}/benchmarks-latest.csv)
+set(ARGS --label ${COMMIT} --output ${CSV})
+if(EXISTS ${LATEST})
+    list(APPEND ARGS --compare ${LATEST})
+endif()
+
+# The benchmarks exit with 2 if a case has regressed. The previous results are then kept,
+# so delete benchmarks-latest.csv to accept the new results.
+execute_process(COMMAND ${BENCHMARKS} ${ARGS} RESULT_VARIABLE RESULT)
+if(RESULT EQUAL 2)
+    message(FATAL_ERROR "Benchmarks regressed compared with ${LATEST}; results written to ${CSV}")
+elseif(RESULT)
+    message(FATAL_ERROR "Benchmarks failed")
+endif()
+
+message(STATUS "Results written to ${CSV}")
+configure_file(${CSV} ${LATEST} COPYONLY)
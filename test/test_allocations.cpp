@@ -0,0 +1,194 @@
+// Tests the number of memory allocations made by pipelines.
+// This replaces the global operator new to count allocations, so it is
+// built separately from the main test suite. Each test asserts an allocation
+// budget, so that changes that add allocations to a pipeline fail the tests.
+
+#define SEQUENCE_ENABLE_ALLOCATION_COUNTERS 1
+
+#include <sequence.hpp>
+
+#include <cstdlib>
+#include <new>
+#include <map>
+#include <string>
+#include <vector>
+
+#undef NDEBUG
+#include <cassert>
+
+// Allocations from the global heap on this thread
+static thread_local std::uint64_t heap_allocations = 0;
+
+void * operator new(std::size_t size)
+{
+    ++heap_allocations;
+    if(void * p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    ++heap_allocations;
+    return std::malloc(size ? size : 1);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t & nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void * p) noexcept { std::free(p); }
+void operator delete[](void * p) noexcept { std::free(p); }
+void operator delete(void * p, const std::nothrow_t &) noexcept { std::free(p); }
+void operator delete[](void * p, const std::nothrow_t &) noexcept { std::free(p); }
+
+// Prevents the compiler from removing the computation of a result
+volatile std::int64_t sink;
+
+// The number of heap allocations made by a function
+template<typename Fn>
+std::uint64_t allocations(Fn fn)
+{
+    auto before = heap_allocations;
+    fn();
+    return heap_allocations - before;
+}
+
+const int N = 10000;
+
+// Pipelines of non-allocating sources and stages do not allocate
+void test_pipelines()
+{
+    std::vector<int> data(N, 3);
+    auto p = seq(data.data(), data.data() + data.size());
+    auto even = [](int x) { return x%2==0; };
+    auto square = [](int x) { return x*x; };
+
+    assert(allocations([&] {
+        sink = seq<std::int64_t>(0, N).where([](std::int64_t x) { return x%2==0; }).select([](std::int64_t x) { return x*x; }).sum();
+    }) == 0);
+    assert(allocations([&] { sink = p.where(even).select(square).sum(); }) == 0);
+    assert(allocations([&] { sink = p.take(N/2).skip(10).sum(); }) == 0);
+    assert(allocations([&] { sink = (p + seq(0, N)).sum(); }) == 0);
+    assert(allocations([&] { sink = p.merge(seq(0, N), [](int a, int b) { return a*b; }).sum(); }) == 0);
+    assert(allocations([&] { sink = p.repeat(3).sum(); }) == 0);
+    assert(allocations([&] { sink = p.take_while([](int x) { return x < 4; }).skip_until(even).size(); }) == 0);
+    assert(allocations([&] { sink = p.count(3) + p.find(4).size() + p.index_of(3); }) == 0);
+    assert(allocations([&] { sink = p.front() + p.back() + p.any(even); }) == 0);
+
+    // Iterating using sequence<T>& uses virtual calls, but does not allocate
+    assert(allocations([&] {
+        const sequence<int> & v = p.where(even).select(square);
+        sink = v.sum();
+    }) == 0);
+}
+
+// Strings allocate when they are longer than the small-string buffer.
+// Tokens are long enough to allocate.
+void test_strings()
+{
+    std::string token(40, 'x'), small_text, large_text;
+    for(int i=0; i<10; ++i) small_text += token + ",";
+    for(int i=0; i<1000; ++i) large_text += token + ",";
+
+    // split() reuses its token, so it only allocates while the token grows, however many tokens there are
+    auto split_small = allocations([&] { sink = seq(small_text).split(",").size(); });
+    auto split_large = allocations([&] { sink = seq(large_text).split(",").size(); });
+    assert(split_small <= 4);
+    assert(split_large == split_small);
+
+    // select() creates a new string for each element
+    assert(allocations([&] {
+        sink = seq(0, N).select([&](int) { return token; }).accumulate(0, [](int & n, const std::string & s) { n += s.size(); });
+    }) <= N + 1);
+
+    // join() computes the length of the string before allocating it
+    assert(allocations([&] { sink = list('a').repeat(N).join().size(); }) == 1);
+
+    // accumulate() appends to the same string, which grows geometrically
+    assert(allocations([&] {
+        sink = list('a').repeat(N).accumulate(std::string(), [](std::string & str, char ch) { str += ch; }).size();
+    }) <= 32);
+
+    // aggregate() passes the accumulator by value, so copies it for each element.
+    // Use accumulate() instead.
+    assert(allocations([&] {
+        sink = list('a').repeat(N).aggregate(std::string(), [](const std::string & str, char ch) { return str + ch; }).size();
+    }) <= 2*N);
+}
+
+// Each stage stores a copy of the sequence before it, so pipelines over a
+// stored container copy the container once per stage
+void test_stored()
+{
+    std::vector<int> data(N, 2);
+
+    assert(allocations([&] { sink = seq(std::vector<int>(data)).sum(); }) == 1);
+    assert(allocations([&] { sink = seq(std::vector<int>(data)).where([](int x) { return x>1; }).sum(); }) <= 2);
+    assert(allocations([&] { sink = seq(std::vector<int>(data)).where([](int x) { return x>1; }).select([](int x) { return x*x; }).sum(); }) <= 3);
+
+    // Passing a pointer_sequence avoids the copies
+    assert(allocations([&] { sink = seq(data).where([](int x) { return x>1; }).select([](int x) { return x*x; }).sum(); }) == 0);
+}
+
+// Internal buffers are counted by the library, and come from the current arena if there is one
+void test_buffers()
+{
+    auto & counters = sequences::allocation_counters::current();
+    counters.reset();
+
+    auto heap = allocations([&] {
+        auto cached = seq(0, N).cached();
+        sink = cached.sum() + cached.sum();
+    });
+    assert(heap > 0);
+    assert(counters.heap_allocations == heap);
+    assert(counters.heap_bytes >= N * sizeof(int));
+    assert(counters.arena_allocations == 0);
+
+    // An arena with an initial buffer does not use the heap
+    counters.reset();
+    static char buffer[256<<10];
+    sequences::arena arena(buffer, sizeof(buffer));
+    assert(allocations([&] {
+        sequences::arena_scope scope(arena);
+        auto cached = seq(0, N).cached();
+        sink = cached.sum() + cached.sum();
+        sink = seq(0, N).window(16).size();
+    }) == 0);
+    assert(counters.heap_allocations == 0);
+    assert(counters.arena_allocations > 0);
+    assert(counters.arena_bytes == arena.bytes_allocated());
+}
+
+// Lookahead stages allocate a ring buffer
+void test_prefetch()
+{
+    std::vector<int> data(N, 1);
+    std::vector<const int*> pointers(N, data.data());
+    assert(allocations([&] { sink = seq(pointers).prefetch(16).size(); }) == 1);
+    assert(allocations([&] { sink = gather(seq(0, N-1), data.data(), 16).sum(); }) == 1);
+
+    // Elements of containers are read ahead by pointer, so strings are not copied
+    std::map<int, std::string> names;
+    for(int i=0; i<N; ++i) names[i] = std::string(100, 'x');
+    assert(allocations([&] { sink = seq(names).prefetch(16).size(); }) == 1);
+
+    // Stages after prefetch() store a copy of it, which has its own buffer
+    assert(allocations([&] { sink = seq(pointers).prefetch(16).select([](const int * p) { return *p; }).sum(); }) <= 2);
+}
+
+int main()
+{
+    test_pipelines();
+    test_strings();
+    test_stored();
+    test_buffers();
+    test_prefetch();
+    return 0;
+}
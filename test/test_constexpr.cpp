@@ -0,0 +1,67 @@
+// Tests that sequences can be evaluated at compile time.
+// This is compiled as C++17 and C++20, which support constexpr lambdas.
+
+#include <sequence.hpp>
+
+#undef NDEBUG
+#include <cassert>
+
+static_assert(seq(1,10).sum() == 55, "Closed-form range");
+static_assert(seq(1,10).size() == 10, "Closed-form range");
+static_assert(seq(1,100,3).back() == 100, "Stepped range");
+
+// Probes are not part of the pipeline unless SEQUENCE_ENABLE_PROFILING is enabled
+static_assert(std::is_same<decltype(seq(1,10).probe("range")), decltype(seq(1,10))>::value, "Disabled probe");
+
+// Pipelines are evaluated inside a constexpr function, because GCC cannot compare
+// pointers into temporaries in a namespace-scope static_assert.
+constexpr bool test_pipelines()
+{
+    constexpr int data[] = { 3, 1, 4, 1, 5 };
+
+    return seq(1,100).where([](int x) { return x%3==0; }).size() == 33 &&
+        list(1,2,3).select([](int x) { return x*x; }).sum() == 14 &&
+        seq(1,10).where([](int) { return true; }).skip(2).take(3).sum() == 3+4+5 &&
+        list(1,2,3,4,5).aggregate(1, [](int a, int b) { return a*b; }) == 120 &&
+        list(4,5,6).at(1) == 5 &&
+        list(4,5,6).any([](int x) { return x>5; }) &&
+        seq(1,10).where([](int x) { return x>10; }).empty() &&
+        seq(data).sum() == 14;
+}
+
+static_assert(test_pipelines(), "Pipelines");
+
+// Lookup tables
+constexpr auto squares = seq(0,9).select([](int x) { return x*x; }).to_array<10>();
+static_assert(squares[9] == 81, "Table of squares");
+
+constexpr auto crc_table = seq(0u,255u).select([](unsigned n) {
+    for(int k=0; k<8; ++k)
+        n = n&1 ? 0xEDB88320u ^ (n>>1) : n>>1;
+    return n;
+}).to_array<256>();
+static_assert(crc_table[1] == 0x77073096u && crc_table[255] == 0x2D02EF8Du, "CRC table");
+
+constexpr auto is_digit = seq(0,127).select([](int ch) { return ch>='0' && ch<='9'; }).to_array<128>();
+static_assert(is_digit['7'] && !is_digit['a'], "Character class table");
+
+constexpr auto primes = seq(2,100).where([](int n) {
+    return !seq(2,n/2).any([n](int d) { return n%d==0; });
+}).to_array<25>();
+static_assert(primes[0] == 2 && primes[24] == 97, "Prime table");
+
+int main()
+{
+    assert(crc_table[128] == 0xEDB88320u);
+    assert(primes[10] == 31);
+
+    // to_array() throws at run time if the size is wrong, and fails to compile at compile time
+    bool thrown = false;
+    try { seq(1,10).to_array<5>(); } catch(std::length_error&) { thrown = true; }
+    assert(thrown);
+    thrown = false;
+    try { seq(1,10).to_array<11>(); } catch(std::length_error&) { thrown = true; }
+    assert(thrown);
+
+    return 0;
+}
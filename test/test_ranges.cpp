@@ -0,0 +1,59 @@
+// Tests that sequences work with C++20 ranges and parallel algorithms.
+// This is compiled as C++20, and tests parallel algorithms if TEST_PARALLEL_ALGORITHMS is set.
+
+#include <sequence.hpp>
+
+#if TEST_PARALLEL_ALGORITHMS
+#include <execution>
+#endif
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#undef NDEBUG
+#include <cassert>
+
+static_assert(std::ranges::input_range<decltype(seq(1,10).where([](int x) { return x>5; }))>, "Sequences are input ranges");
+static_assert(std::input_iterator<decltype(seq(1,10).begin())>, "Input iterator");
+static_assert(std::ranges::contiguous_range<decltype(seq("abc").range())>, "Contiguous range");
+static_assert(std::ranges::random_access_range<decltype(seq(1,10).range())>, "Random-access range");
+static_assert(std::ranges::sized_range<decltype(seq(1,10).range())>, "Sized range");
+static_assert(std::ranges::forward_range<decltype(seq(1,10).select([](int x) { return x*2; }).range())>, "Forward range");
+static_assert(std::ranges::view<decltype(seq(1,10).select([](int x) { return x*2; }).range())>, "View");
+static_assert(std::ranges::view<decltype(seq(1,10).range())>, "View");
+
+int main()
+{
+    auto squares = seq(1,10).select([](int x) { return x*x; }).range();
+
+    // Views
+    auto odd = squares | std::views::filter([](int x) { return x%2; }) | std::views::transform([](int x) { return x+1; });
+    assert(std::ranges::distance(odd) == 5);
+    assert(*std::ranges::begin(odd) == 2);
+    auto taken = seq(1,100).range() | std::views::reverse | std::views::take(3);
+    assert(std::ranges::equal(taken, std::vector<int>({100, 99, 98})));
+
+    // Range algorithms
+    assert(*std::ranges::max_element(squares) == 100);
+    assert(std::ranges::find(squares, 49) != squares.end());
+    assert(std::ranges::count_if(seq(1,10).range(), [](int x) { return x > 3; }) == 7);
+
+#if TEST_PARALLEL_ALGORITHMS
+    // Parallel algorithms
+    auto numbers = seq(1,1000).range();
+    assert(std::reduce(std::execution::par, numbers.begin(), numbers.end(), 0) == 500500);
+    assert(std::reduce(std::execution::par, squares.begin(), squares.end(), 0) == 385);
+    std::vector<int> data(1000);
+    std::iota(data.begin(), data.end(), 0);
+    auto pointers = seq(data).range();
+    assert(std::transform_reduce(std::execution::par, pointers.begin(), pointers.end(), 0L, std::plus<>(), [](int x) { return long(x); }) == 499500);
+#endif
+
+    // Sequences are read-only, so sort a copy
+    auto words = list<std::string>("c","a","b").select([](const std::string & s) { return s + s; }).range();
+    std::vector<std::string> sorted(words.begin(), words.end());
+    std::ranges::sort(sorted);
+    assert(sorted == std::vector<std::string>({"aa", "bb", "cc"}));
+    return 0;
+}
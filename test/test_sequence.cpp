@@ -4,14 +4,28 @@
 // This is the main header file to include, which includes everything
 // You can also #include <sequence_fwd.hpp> if you just need the forward declaration.
 
+#ifndef _WIN32
+#define SEQUENCE_ENABLE_POSIX 1
+#endif
+
+// Test block evaluation whether or not the compiler targets AVX2
+#define SEQUENCE_ENABLE_BLOCKS 1
+
+#define SEQUENCE_ENABLE_PROFILING 1
+#define SEQUENCE_ENABLE_CONCURRENT_OUTPUT 1
+
 #include <sequence.hpp>
 
 #include <iostream>
 #include <vector>
 #include <map>
+#include <list>
+#include <set>
 #include <fstream>
 #include <sstream>
 #include <future>
+#include <climits>
+#include <numeric>
 
 #undef NDEBUG
 #include <cassert>
@@ -107,6 +121,270 @@ void test_writers()
      copy(list("writer1","writer2"), receiver([&](const char * str){vec.push_back(str);}));
 }
 
+// An output sequence that records how elements were added
+struct counting_output : public output_sequence<int>
+{
+    mutable int elements = 0, ranges = 0;
+    mutable std::size_t reserved = 0;
+
+    void add(const int &) const override { ++elements; }
+    void add_range(const int * b, const int * e) const override { ++ranges; elements += e-b; }
+    void reserve(std::size_t n) const override { reserved += n; }
+};
+
+void test_bulk_output()
+{
+    // Contiguous sequences are written in a single call
+    counting_output out;
+    int array[] = { 1,2,3,4,5 };
+    out << seq(array);
+    assert(out.ranges == 1 && out.elements == 5);
+
+    const output_sequence<int> & output = out;
+    list(1,2,3).write_to(output);
+    assert(out.ranges == 2 && out.elements == 8);
+
+    // Other sized sequences reserve space first
+    out << seq(1,10).select([](int x) { return x*2; });
+    assert(out.ranges == 2 && out.elements == 18 && out.reserved == 10);
+
+    // Unsized sequences are written element by element
+    out << seq(1,10).where([](int x) { return x%2==0; });
+    assert(out.elements == 23 && out.reserved == 10);
+
+    // Containers are reserved from the size of the sequence
+    std::vector<int> vec;
+    writer(vec) << seq(1,1000).select([](int x) { return x; });
+    assert(vec.size() == 1000 && vec.capacity() == 1000);
+
+    auto vec2 = seq(vec).make<std::vector<int>>();
+    assert(vec2 == vec && vec2.capacity() == 1000);
+
+    // Associative containers
+    auto set = seq(1,1000).make<std::set<int>>();
+    assert(set.size() == 1000 && *set.begin() == 1 && *set.rbegin() == 1000);
+
+    std::map<int, std::string> map;
+    writer(map) << seq(1,3).select([](int x) { return std::make_pair(x, std::to_string(x)); });
+    assert(map.size() == 3 && map[2] == "2");
+
+    std::set<int> set2;
+    writer(set2) << seq(vec);
+    assert(set2 == set);
+
+    // Elements can be moved into the output
+    std::vector<std::string> strings;
+    std::string str(100, 'x');
+    writer(strings) << std::move(str);
+    assert(strings.size() == 1 && strings[0].size() == 100 && str.empty());
+}
+
+#if SEQUENCE_ENABLE_POSIX
+std::string read_file(const char * path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+void test_file_writer()
+{
+    const char * path = "test_output.txt";
+
+    file_writer<int>(path) << seq(1,5);
+    assert(read_file(path) == "1\n2\n3\n4\n5\n");
+
+    file_writer<long long>(path, ",") << list(0LL, -7LL, 1234567890123LL, LLONG_MIN, LLONG_MAX);
+    assert(read_file(path) == "0,-7,1234567890123,-9223372036854775808,9223372036854775807,");
+
+    file_writer<double>(path, " ") << list(0.1, -2.5, 1e300, 3.0);
+    assert(read_file(path) == "0.1 -2.5 1e+300 3 ");
+
+    file_writer<float>(path, " ") << list(0.1f, 1.5f);
+    assert(read_file(path) == "0.1 1.5 ");
+
+    file_writer<char>(path, nullptr) << seq("hello");
+    assert(read_file(path) == "hello");
+
+    file_writer<const char*>(path, " ") << list("a", "b");
+    assert(read_file(path) == "a b ");
+
+    // Strings larger than the buffer are written directly
+    std::string large(200000, 'x');
+    {
+        auto out = file_writer<std::string>(path);
+        out << "a" << large << "b";
+    }
+    assert(read_file(path) == "a\n" + large + "\nb\n");
+
+    // Writing to an existing file descriptor
+    {
+        int fd = ::open(path, O_WRONLY|O_TRUNC);
+        assert(fd>=0);
+        {
+            const output_sequence<int> & out = file_writer<int>(fd, " ");
+            out.add(1);
+            out << seq(2,3);
+        }
+        ::close(fd);
+    }
+    assert(read_file(path) == "1 2 3 ");
+
+    // Small buffers still have room for formatted numbers
+    {
+        int fd = ::open(path, O_WRONLY|O_TRUNC);
+        assert(fd>=0);
+        sequences::fd_output<double>(fd, " ", 1) << list(0.1, -2.5, 1e300);
+        sequences::fd_output<long long>(fd, " ", 1) << list(LLONG_MIN, 2LL);
+        ::close(fd);
+    }
+    assert(read_file(path) == "0.1 -2.5 1e+300 -9223372036854775808 2 ");
+
+    // Binary output
+    int values[] = { 1, 2, 3, 4 };
+    binary_file_writer<int>(path) << seq(values) << 5;
+    auto data = read_file(path);
+    assert(data.size() == 5*sizeof(int));
+    int read_values[5];
+    std::memcpy(read_values, data.data(), data.size());
+    assert(read_values[0]==1 && read_values[3]==4 && read_values[4]==5);
+
+    struct point { int x; double y; };
+    binary_file_writer<point>(path) << seq(1,100000).select([](int x) { return point{x, x*0.5}; });
+    assert(read_file(path).size() == 100000 * sizeof(point));
+
+    std::remove(path);
+}
+
+void test_file_reader()
+{
+    const char * path = "test_input.txt";
+    std::string text;
+    for(int i=0; i<1000; ++i) text += std::to_string(i) + "\n";
+    std::ofstream(path, std::ios::binary) << text;
+
+    // Buffers of different sizes, including buffers that divide the file exactly
+    for(std::size_t buffer_size : {1, 7, 3890, 1<<20})
+    {
+        auto file = file_reader(path, buffer_size, 3);
+        assert(file.size() == text.size());
+        assert(file == seq(text));
+        assert(file.split("\n").size() == 1000);
+    }
+
+    // Blocks and chunks point into the buffers
+    auto file = file_reader(path, 1000, 2, false);
+    assert(file.hash<sequences::crc32c>() == seq(text).hash<sequences::crc32c>());
+    assert(file.select([](char ch) { return int(ch); }).sum() == seq(text).select([](char ch) { return int(ch); }).sum());
+    auto chunks = file.chunks();
+    assert(chunks.size() == 4);
+    assert(chunks.select([](const pointer_sequence<char> & c) { return c.size(); }) == list(1000, 1000, 1000, 890));
+
+    // Stopping early, iterating again, and iterating copies
+    assert(file.take(4) == seq("0\n1\n"));
+    assert(file.take(4) == seq("0\n1\n"));
+    auto copy = file;
+    auto i = file.begin();
+    assert(*copy.begin() == '0' && *i == '0');
+    const sequence<char> & v = file;
+    assert(v.count('\n') == 1000);
+
+    // An existing file descriptor, and a pipe
+    int fd = ::open(path, O_RDONLY);
+    assert(fd >= 0);
+    assert(file_reader(fd, 100).size() == text.size());
+    ::close(fd);
+
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    auto writer = std::async(std::launch::async, [&] { file_writer<char>(fds[1], nullptr) << seq(text); ::close(fds[1]); });
+    assert(file_reader(fds[0], 100) == seq(text));
+    writer.get();
+    ::close(fds[0]);
+
+    // Data from a pipe is read as it arrives, and stopping early does not wait for the writer
+    assert(::pipe(fds) == 0);
+    assert(::write(fds[1], "abcdef", 6) == 6);
+    assert(file_reader(fds[0], 100).take(2) == seq("ab"));
+    ::close(fds[1]);
+    ::close(fds[0]);
+
+    std::ofstream(path, std::ios::binary | std::ios::trunc);
+    assert(file_reader(path).empty());
+    std::remove(path);
+
+    bool thrown = false;
+    try { file_reader("no/such/file"); } catch(std::runtime_error &) { thrown = true; }
+    assert(thrown);
+}
+#endif
+
+void test_concurrent_output()
+{
+    // Unordered output from many threads
+    std::vector<int> vec;
+    {
+        auto w = writer(vec);
+        sequences::concurrent_output<int> out(w, false, 100);
+        std::vector<std::thread> threads;
+        for(int t=0; t<4; ++t)
+            threads.emplace_back([&out] { out << seq(1,10000); });
+        for(auto &t: threads) t.join();
+    }
+    assert(vec.size() == 40000);
+    assert(seq(vec).sum() == 4 * 50005000);
+
+    // Each thread's elements stay in order
+    std::vector<std::pair<int,int>> pairs;
+    for(int ordered=0; ordered<2; ++ordered)
+    {
+        pairs.clear();
+        auto w = writer(pairs);
+        sequences::concurrent_output<std::pair<int,int>> out(w, ordered, 64);
+        std::vector<std::thread> threads;
+        for(int t=0; t<4; ++t)
+            threads.emplace_back([&out, t] { for(int i=0; i<5000; ++i) out.add(std::make_pair(t, i)); });
+        for(auto &t: threads) t.join();
+        out.flush();
+
+        assert(pairs.size() == 20000);
+        int last[4] = { -1, -1, -1, -1 };
+        for(auto &p : pairs)
+        {
+            assert(p.second == last[p.first]+1);
+            last[p.first] = p.second;
+        }
+    }
+
+    // Ordered output from a single thread is in order
+    std::vector<int> vec2;
+    {
+        auto w = writer(vec2);
+        sequences::concurrent_output<int> out(w, true, 7);
+        out << seq(1,1000);
+        out.flush();
+        assert(vec2.size() == 1000);
+        out << seq(1001,1010);
+    }
+    assert(vec2 == seq(1,1010).make<std::vector<int>>());
+
+    // Errors are reported by flush()
+    auto fail = receiver([](int x) { if(x==50) throw std::runtime_error("fail"); });
+    sequences::concurrent_output<int> out(fail, false, 10);
+    out << seq(1,100);
+    bool thrown = false;
+    try
+    {
+        out.flush();
+    }
+    catch(std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
 void test_repeat()
 {
     assert(list(1,1,1)==list(1).repeat(3));
@@ -224,6 +502,96 @@ void test_range()
     //    std::cout << x << std::endl;
 }
 
+// Checks the closed-form operations of a range against iterating it
+template<typename Int>
+void check_range(const sequences::range_sequence<Int> & range)
+{
+    std::size_t size = 0;
+    Int sum = 0;
+    for(auto x : range)
+    {
+        assert(range.at(size) == x);
+        sum = Int(std::uint64_t(sum) + std::uint64_t(x));
+        ++size;
+    }
+    assert(range.size() == size);
+    assert(range.sum() == sum);
+    if(size) assert(range.back() == range.reverse().front());
+
+    for(Int d=1; d<=6; ++d)
+        for(Int r=0; r<d; ++r)
+        {
+            sequences::modulo<Int> p(d, r);
+            assert(range.count(p) == range.where(p).size());
+        }
+
+    for(std::size_t n=0; n<=size+1; ++n)
+    {
+        assert(range.take(n) == range.where([](Int) { return true; }).take(n));
+        assert(range.skip(n) == range.where([](Int) { return true; }).skip(n));
+    }
+}
+
+void test_range_closed_form()
+{
+    assert(seq(1,10,3) == list(1,4,7,10));
+    assert(seq(10,1,-4) == list(10,6,2));
+    assert(seq(1,0).empty());
+    assert(seq(5,1).empty());
+    assert(seq(1,5,-1).empty());
+    assert(seq('a','e').size() == 5);
+    assert(seq(1,10).take(-1).empty());
+    assert(seq(1,10).skip(-2) == seq(1,10));
+    assert(seq(1,10).skip(-2).take(-2).empty());
+
+    // Arguments are promoted, and mixed signs give a signed range
+    static_assert(std::is_same<decltype(seq('a','e'))::value_type, int>::value, "seq(char, char) is an int range");
+    static_assert(std::is_same<decltype(seq(-1,5u))::value_type, int>::value, "seq(int, unsigned) is an int range");
+    static_assert(std::is_same<decltype(seq(0u,5u))::value_type, unsigned>::value, "seq(unsigned, unsigned) is unsigned");
+    assert(seq(-1,5u).size() == 7);
+    assert(seq(-1,5u,2) == list(-1,1,3,5));
+    std::vector<int> empty;
+    assert(seq(0, empty.size()-1).empty());
+    assert(seq(sequences::int_iterator(1), sequences::int_iterator(4)) == list(1,2,3));
+    assert(seq(1,5).reverse() == list(5,4,3,2,1));
+
+    bool thrown = false;
+    try { seq(1,10,0); } catch(std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+    thrown = false;
+    try { seq(1,10).at(10); } catch(std::out_of_range&) { thrown = true; }
+    assert(thrown);
+
+    check_range(seq(-20,20));
+    check_range(seq(-20,21,3));
+    check_range(seq(17,-30,-7));
+    check_range(seq(5,5));
+    check_range(seq(5,4));
+    check_range(seq(0u,40u,6));
+    check_range(seq(40u,0u,-5));
+    check_range(seq<short>(-100,100,9));
+    check_range(seq(std::int64_t(-50), std::int64_t(50), 11));
+
+    // 64-bit ranges are not limited to int, and do not iterate
+    const std::int64_t big = std::int64_t(1)<<40;
+    auto ids = seq(big, 4*big-1);
+    assert(ids.size() == 3*big);
+    assert(ids.at(big) == 2*big);
+    assert(ids.back() == 4*big-1);
+    assert(ids.sum() == std::int64_t(std::uint64_t(5*big-1)*std::uint64_t(3*big/2)));
+    assert(ids.count(sequences::modulo<std::int64_t>(3)) == big);
+    assert(ids.skip(big).take(2) == list(2*big, 2*big+1));
+    assert(seq(std::uint64_t(0), ~std::uint64_t(0), std::int64_t(1)<<62).size() == 4);
+
+    // Sums wrap around in the same way as iterating
+    assert(seq(0u,100000u).sum() == seq(0u,100000u).where([](unsigned) { return true; }).sum());
+
+    auto naturals = iota(std::uint64_t(1));
+    assert(naturals.take(3) == list<std::uint64_t>(1u,2u,3u));
+    assert(naturals.skip(big).front() == std::uint64_t(big+1));
+    assert(iota(10, -2).take(3) == list(10,8,6));
+}
+
 void test_comparisons()
 {
     auto e = list<int>();
@@ -368,6 +736,288 @@ void test_merge()
 
     assert(list(1).merge(list(3,4), sum) == list(4));
     assert(list(1,2).merge(list(3), sum) == list(4));
+
+    // Sequences passed as sequence<T>&
+    auto l = list(1,2);
+    const sequence<int> & v = l;
+    assert(list(3,4).merge(v, sum) == list(4,6));
+    assert(v.merge(list(3,4), sum) == list(4,6));
+    assert(v + v == list(1,2,1,2));
+    assert(list(0).concat(v) == list(0,1,2));
+}
+
+void test_zip()
+{
+    auto z = zip(list(1,2,3), list<std::string>("a","b","c"), list(0.5, 1.5, 2.5));
+    assert(z.size() == 3);
+    assert(z.front() == std::make_tuple(1, std::string("a"), 0.5));
+    assert(z.back() == std::make_tuple(3, std::string("c"), 2.5));
+
+    // The shortest sequence ends the zip
+    assert(seq(1,100).zip(list('a','b')).size() == 2);
+    assert(seq(1,100).zip(list<int>()).empty());
+    typedef std::tuple<int,int> T2;
+    assert(seq(1,3).zip(seq(4,6)).select([](const T2 & t) { return std::get<0>(t)*std::get<1>(t); }) == list(4,10,18));
+
+    // Lazy evaluation
+    int evaluated = 0;
+    auto counted = seq(1,1000000).select([&](int x) { ++evaluated; return x; });
+    assert(zip(counted, counted).take(3).size() == 3);
+    assert(evaluated < 10);
+}
+
+void test_merge_sorted()
+{
+    assert(merge_sorted(list(1,4,7), list(2,5,8), list(3,6,9)) == seq(1,9));
+    assert(merge_sorted(list(1,1,5), list<int>(), list(0,9)) == list(0,1,1,5,9));
+    assert(merge_sorted(list(7,4,1), list(8,5,2), std::greater<int>()) == list(8,7,5,4,2,1));
+    assert(merge_sorted(list<int>(), list<int>()).empty());
+
+    // Sequences of different types
+    assert(merge_sorted(list(1,3), seq(2,2), list(0,4,5)) == seq(0,5));
+    const sequence<int> & a = seq(1,10).where([](int x) { return x%3==0; });
+    const sequence<int> & b = list(2,5,11);
+    const sequence<int> & c = seq(1,10).where([](int x) { return x%2==1; });
+    assert(merge_sorted(a, b, c) == list(1,2,3,3,5,5,6,7,9,9,11));
+
+    // Sequences of sequences
+    std::vector<std::vector<int>> shards(20);
+    for(int i=0; i<1000; ++i)
+        shards[(i*7)%20].push_back(i);
+    std::vector<sequences::iterator_sequence<std::vector<int>::const_iterator>> shard_seqs;
+    for(auto & shard : shards)
+        shard_seqs.push_back(seq(shard));
+    auto merged = merge_sorted(seq(shard_seqs));
+    assert(merged == seq(0,999));
+    assert(merged == seq(0,999));
+    assert(seq(shard_seqs).merge_sorted(std::less<int>()).size() == 1000);
+
+    // Equal elements are taken from earlier sequences first
+    typedef std::pair<int,int> P;
+    auto byFirst = [](const P & x, const P & y) { return x.first < y.first; };
+    auto stable = merge_sorted(list(P(1,0), P(2,0)), list(P(1,1), P(2,1)), list(P(1,2)), byFirst);
+    assert(stable == list(P(1,0), P(1,1), P(1,2), P(2,0), P(2,1)));
+
+    // Single sequence
+    auto single = list(list(3,4));
+    assert(merge_sorted(single) == list(3,4));
+    typedef sequences::stored_sequence<std::array<int,2>> S;
+    assert(list<S>().merge_sorted().empty());
+}
+
+void test_set_operations()
+{
+    assert(list(1,2,4,5).set_union(list(2,3,5,6)) == list(1,2,3,4,5,6));
+    assert(list(1,2,4,5).set_intersection(list(2,3,5,6)) == list(2,5));
+    assert(list(1,2,4,5).set_difference(list(2,3,5,6)) == list(1,4));
+    assert(list(1,2,4,5).set_symmetric_difference(list(2,3,5,6)) == list(1,3,4,6));
+
+    auto e = list<int>();
+    assert(e.set_union(list(1,2)) == list(1,2));
+    assert(list(1,2).set_intersection(e).empty());
+    assert(list(1,2).set_difference(e) == list(1,2));
+    assert(e.set_symmetric_difference(e).empty());
+
+    // Duplicates behave like the std algorithms
+    assert(list(1,1,1,2).set_union(list(1,2,2)) == list(1,1,1,2,2));
+    assert(list(1,1,1,2).set_intersection(list(1,1,3)) == list(1,1));
+    assert(list(1,1,1,2).set_difference(list(1,3)) == list(1,1,2));
+
+    // Compare against the std algorithms, for seekable and unseekable sequences
+    std::vector<int> a, b;
+    for(int i=0; i<2000; ++i)
+    {
+        if(i%3==0 || i%7==0) a.push_back(i);
+        if(i%5==0 || i>1900) b.push_back(i);
+    }
+    std::list<int> la(a.begin(), a.end()), lb(b.begin(), b.end());
+
+    std::vector<int> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(seq(a).set_intersection(seq(b)) == seq(expected));
+    assert(seq(la).set_intersection(seq(lb)) == seq(expected));
+
+    expected.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(seq(a).set_difference(seq(b)) == seq(expected));
+    assert(seq(la).set_difference(seq(lb)) == seq(expected));
+
+    expected.clear();
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(seq(a).set_union(seq(lb)) == seq(expected));
+
+    expected.clear();
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    assert(seq(la).set_symmetric_difference(seq(b)) == seq(expected));
+
+    // Random-access sequences skip ahead
+    std::vector<int> dense = seq(0,999999).make<std::vector<int>>();
+    int comparisons = 0;
+    auto counting_less = [&](int x, int y) { ++comparisons; return x<y; };
+    assert(list(10, 500000, 999999).set_intersection(seq(dense), counting_less) == list(10, 500000, 999999));
+    assert(comparisons < 200);
+
+    comparisons = 0;
+    assert(list(-1, 500000, 2000000).set_difference(seq(dense), counting_less) == list(-1, 2000000));
+    assert(comparisons < 200);
+
+    // Descending order
+    assert(list(5,3,1).set_union(list(4,2), std::greater<int>()) == list(5,4,3,2,1));
+}
+
+void test_windows()
+{
+    auto windows = seq(1,5).window(3);
+    assert(windows.size() == 3);
+    assert(windows.select([](const pointer_sequence<int> & w) { return w.sum(); }) == list(6,9,12));
+    assert(windows.front() == list(1,2,3));
+    assert(windows.back() == list(3,4,5));
+
+    assert(seq(1,10).window(3,2).select([](const pointer_sequence<int> & w) { return w.front(); }) == list(1,3,5,7));
+    assert(seq(1,10).window(2,4).select([](const pointer_sequence<int> & w) { return w.front(); }) == list(1,5,9));
+    assert(seq(1,7).tumbling(3).select([](const pointer_sequence<int> & w) { return w.back(); }) == list(3,6));
+    assert(seq(1,2).window(3).empty());
+
+    // Strings
+    auto words = list<std::string>("a","b","c").window(2).select([](const pointer_sequence<std::string> & w) { return w.sum(); });
+    assert(words == list<std::string>("ab", "bc"));
+
+    // Rolling aggregates
+    auto values = list(5, 1, 4, 2, 8, 3, 3, 7);
+    assert(values.rolling_sum(3) == list(10, 7, 14, 13, 14, 13));
+    assert(values.rolling_min(3) == list(1, 1, 2, 2, 3, 3));
+    assert(values.rolling_max(3) == list(5, 4, 8, 8, 8, 7));
+    assert(values.rolling_mean(2) == list(3.0, 2.5, 3.0, 5.0, 5.5, 3.0, 5.0));
+    assert(values.rolling_min(1) == values);
+    assert(values.rolling_max(100).empty());
+
+    // Compare against re-aggregating each window
+    auto data = seq(1,1000).select([](int x) { return (x*7919)%1009; }).make<std::vector<int>>();
+    auto slow_max = seq(0,990).select([&](int i) { return seq(data).skip(i).take(10).aggregate([](int a, int b) { return a>b ? a : b; }); });
+    assert(seq(data).rolling_max(10) == slow_max);
+    assert(seq(data).rolling_sum(10) == seq(data).window(10).select([](const pointer_sequence<int> & w) { return w.sum(); }));
+
+    // Single-pass sequences
+    std::stringstream ss("abcdef");
+    assert(seq(ss).rolling_max(2) == seq("bcdef"));
+}
+
+void test_chunk()
+{
+    // Contiguous sequences are not copied
+    int array[] = { 1,2,3,4,5,6,7 };
+    auto chunks = seq(array).chunk(3);
+    assert(chunks.size() == 3);
+    assert(chunks.chunk_size() == 3);
+    assert(chunks.front() == list(1,2,3));
+    assert(chunks.front().data() == array);
+    assert(chunks.back() == list(7));
+    assert(chunks.select([](const pointer_sequence<int> & c) { return c.sum(); }) == list(6,15,7));
+
+    std::string str = "abcdefgh";
+    assert(seq(str).chunk(4).back().data() == str.data()+4);
+    const std::string & cstr = str;
+    assert(seq(cstr).chunk(4).back().data() == str.data()+4);
+
+    // Only strings of character types are detected, so std::basic_string<int> is not instantiated
+    static_assert(sequences::helpers::is_contiguous_iterator<std::string::const_iterator>::value, "String iterators are contiguous");
+    static_assert(!sequences::helpers::is_character<int>::value && !sequences::helpers::is_character<bool>::value, "Not characters");
+    static_assert(!sequences::helpers::is_contiguous_iterator<std::list<long>::const_iterator>::value, "List iterators are not contiguous");
+    std::list<int> numbers = {1,2,3};
+    assert(seq(numbers).chunk(2).back() == list(3));
+    assert(list(1,2,3,4).chunk(2).size() == 2);
+
+    // Other sequences are copied into a buffer
+    auto evens = seq(1,20).where([](int x) { return x%2==0; }).chunk(4);
+    assert(evens.select([](const pointer_sequence<int> & c) { return c.size(); }) == list(4,4,2));
+    assert(evens.select([](const pointer_sequence<int> & c) { return c.back(); }) == list(8,16,20));
+    assert(seq(1,8).chunk(4).size() == 2);
+    assert(list<int>().chunk(4).empty());
+    assert(seq(1,8).where([](int) { return false; }).chunk(4).empty());
+
+    std::stringstream ss("hello world");
+    assert(seq(ss).chunk(5).select([](const pointer_sequence<char> & c) { return std::string(c.data(), c.size()); }) ==
+        list<std::string>("hello", " worl", "d"));
+
+    // Chunks are written in bulk
+    counting_output out;
+    out << seq(1,10).chunk(4);
+    assert(out.ranges == 3 && out.elements == 10);
+
+    std::vector<int> vec;
+    writer(vec) << seq(array).chunk(2);
+    assert(seq(vec) == seq(array));
+
+    // Windows overlap, so they are not written as chunks
+    static_assert(sequences::helpers::is_chunked<decltype(seq(1,5).chunk(2)), int>::value, "chunk() is chunked");
+    static_assert(!sequences::helpers::is_chunked<decltype(seq(1,5).window(3)), int>::value, "window() is not chunked");
+    int windows = 0;
+    receiver([&](const pointer_sequence<int> & w) { assert(w.size() == 3); ++windows; }) << seq(1,5).window(3);
+    assert(windows == 3);
+
+    // Chunks do not reserve exactly, so the vector grows geometrically
+    std::vector<int> grown;
+    std::size_t reallocations = 0;
+    auto count_reallocations = receiver([&](const pointer_sequence<int> & chunk) {
+        auto capacity = grown.capacity();
+        writer(grown) << chunk;
+        if(grown.capacity() != capacity) ++reallocations;
+    });
+    count_reallocations << seq(1,64000).where([](int) { return true; }).chunk(64);
+    assert(grown.size() == 64000);
+    assert(reallocations < 40);
+}
+
+void test_blocks()
+{
+    auto even = [](int x) { return x%2==0; };
+    auto rare = [](int x) { return x%300==7; };
+    auto square = [](int x) { return x*x; };
+    auto half = [](int x) { return x*0.5; };
+
+    static_assert(sequences::helpers::is_blockwise<decltype(seq(1,10).where(even).select(square))>::value, "Blockwise pipeline");
+    static_assert(!sequences::helpers::is_blockwise<decltype(list(1,2).where(even))>::value, "Not blockwise");
+    static_assert(sequences::helpers::is_masked<decltype(seq(1,10).where(even).select(square).select(half))>::value, "Mask is carried through select()");
+
+    // Blocks give the same results as iterating, at and around block boundaries
+    for(int n : { 0, 1, 63, 64, 65, 1000 })
+    {
+        auto range = seq(1,n);
+        const sequence<int> & iterated = range;
+
+        assert(range.where(even).size() == iterated.where(even).size());
+        assert(range.where(even).sum() == iterated.where(even).sum());
+        assert(range.where(rare).sum() == iterated.where(rare).sum());
+        assert(range.select(square).sum() == iterated.select(square).sum());
+        assert(range.where(even).select(square).sum() == iterated.where(even).select(square).sum());
+        assert(range.where(rare).select(half).sum() == iterated.where(rare).select(half).sum());
+        assert(range.select(square).where(even).size() == iterated.select(square).where(even).size());
+        assert(range.count(even) == iterated.where(even).size());
+        assert(range.where(rare).select(square).select(half).sum() == iterated.where(rare).select(square).select(half).sum());
+        assert(range.where(even).select(half).size() == iterated.where(even).size());
+    }
+
+    // select() is only called on the elements selected by where()
+    auto nonzero = [](int x) { return x!=0; };
+    auto inverse = [](int x) { return 1000/x; };
+    const sequence<int> & around_zero = seq(-100,100);
+    assert(seq(-100,100).where(nonzero).select(inverse).sum() == around_zero.where(nonzero).select(inverse).sum());
+
+    std::vector<double> values;
+    for(int i=0; i<1000; ++i) values.push_back(i*0.25 - 100);
+    pointer_sequence<double> ptr(values.data(), values.data()+values.size());
+    const sequence<double> & iterated = ptr;
+    auto positive = [](double x) { return x>0; };
+    assert(ptr.sum() == iterated.sum());
+    assert(ptr.where(positive).sum() == iterated.where(positive).sum());
+    assert(ptr.where(positive).size() == 599);
+
+    auto ids = seq(std::int64_t(1)<<40, (std::int64_t(1)<<40) + 999, 3);
+    const sequence<std::int64_t> & iterated_ids = ids;
+    auto odd = [](std::int64_t x) { return x%2!=0; };
+    assert(ids.where(odd).sum() == iterated_ids.where(odd).sum());
+    assert(ids.where(odd).select([](std::int64_t x) { return x/2; }).sum() ==
+        iterated_ids.where(odd).select([](std::int64_t x) { return x/2; }).sum());
 }
 
 void test_sum()
@@ -401,6 +1051,368 @@ void test_count()
     assert(list<int>(1,2,3,1,1).count([](int x) { return x==1; })==3);
 }
 
+void test_search()
+{
+    // Contiguous bytes, long enough to use the vector kernels and their tails
+    std::string text;
+    for(int i=0; i<20000; ++i)
+        text += i%97==0 ? '\n' : i%13==0 ? '\t' : char('a' + i%26);
+
+    for(std::size_t length : { 0, 1, 31, 32, 33, 255*32, 255*32+5, 20000 })
+    {
+        std::string str = text.substr(0, length);
+        auto s = seq(str);
+        assert(s.count('\n') == std::size_t(std::count(str.begin(), str.end(), '\n')));
+        assert(s.count('z') == std::size_t(std::count(str.begin(), str.end(), 'z')));
+        assert(s.index_of('\t') == (str.find('\t') == std::string::npos ? s.npos : str.find('\t')));
+        assert(s.contains('\t') == (str.find('\t') != std::string::npos));
+        assert(s.find('\t').size() == (str.find('\t') == std::string::npos ? 0 : length - str.find('\t')));
+        assert(s.find_first_of(seq("\t\n")).size() == (str.find_first_of("\t\n") == std::string::npos ? 0 : length - str.find_first_of("\t\n")));
+        assert(s.find_first_of(seq("\n")).size() == (str.find_first_of("\n") == std::string::npos ? 0 : length - str.find_first_of("\n")));
+        assert(s.find_first_of(seq("0123456789\t")).size() == (str.find_first_of("\t") == std::string::npos ? 0 : length - str.find_first_of("\t")));
+    }
+
+    assert(seq("hello world").find('w').front() == 'w');
+    assert(seq("hello world").find('x').empty());
+    assert(seq("hello world").index_of('o') == 4);
+    assert(seq("hello world").find_first_of(seq("wo")).front() == 'o');
+    assert(seq("hello").find_first_of(seq("")).empty());
+
+    // Other types use the generic path
+    assert(list(1,2,3,2).count(2) == 2);
+    assert(list(1,2,3,2).index_of(3) == 2);
+    assert(list(1,2,3,2).index_of(4) == sequence<int>::npos);
+    assert(list(1,2,3,2).contains(3));
+    assert(!list(1,2,3,2).contains(4));
+    assert(list(1,2,3,2).find(2).size() == 3);
+    assert(list(1,2,3,2).find_first_of(list(5,3)).front() == 3);
+    assert(list(1,2,3).where([](int x) { return x>1; }).index_of(3) == 1);
+    assert(list(1,2,3).count([](int x) { return x>1; }) == 2);
+
+    const int data[] = { 4, 5, 6, 5 };
+    assert(seq(data).count(5) == 2);
+    assert(seq(data).find(6).size() == 2);
+    assert(seq(data).find_first_of(list(6,5)).front() == 5);
+
+    // Ranges are searched in closed form
+    assert(seq(1,100,3).count(7) == 1);
+    assert(seq(1,100,3).index_of(7) == 2);
+    assert(seq(1,100,3).index_of(8) == seq(1,100,3).npos);
+    assert(seq(1,100,3).contains(100));
+    assert(!seq(1,100,3).contains(101));
+    assert(seq(10,1,-1).index_of(1) == 9);
+
+    // Narrow ranges wrap around, so values repeat
+    typedef sequences::range_sequence<std::int8_t> byte_range;
+    for(int step : { 1, 2, 3, -4, 127 })
+        for(int value : { -128, -1, 0, 5, 6, 127 })
+        {
+            auto r = byte_range::with_length(3, 1000, step);
+            const sequence<std::int8_t> & iterated = r;
+            std::int8_t v = value;
+            assert(r.count(v) == r.count([v](std::int8_t x) { return x==v; }));
+            assert(r.index_of(v) == iterated.index_of(v));
+        }
+    assert(seq<std::uint64_t>(0, 1000000000000ull, 6).count(std::uint64_t(600)) == 1);
+}
+
+template<typename Hash>
+void check_hash(const std::string & str, typename Hash::result_type expected)
+{
+    const sequence<char> & iterated = seq(str);
+    assert(seq(str).hash<Hash>() == expected);
+    assert(iterated.hash<Hash>() == expected);
+
+    // Updates can be split anywhere
+    for(std::size_t split : { std::size_t(0), str.size()/3, str.size() })
+    {
+        Hash hash;
+        hash.update(str.data(), split);
+        hash.update(str.data() + split, str.size() - split);
+        assert(hash.value() == expected);
+    }
+
+    sequences::hash_output<Hash, char> out;
+    for(auto ch : str) out << ch;
+    assert(out.value() == expected);
+}
+
+void test_ranges()
+{
+    // Sequences can be iterated using standard input iterators
+    auto evens = seq(1,10).where([](int x) { return x%2==0; });
+    auto i = evens.begin();
+    assert(*i == 2 && i != evens.end());
+    i++;
+    assert(*i == 4);
+    assert(std::accumulate(evens.begin(), evens.end(), 0) == 30);
+
+    // Contiguous sequences give pointers
+    int data[] = { 5, 3, 9, 1 };
+    auto r1 = seq(data).range();
+    assert(r1.begin() == data && r1.size() == 4);
+    assert(*std::max_element(r1.begin(), r1.end()) == 9);
+    auto stored = list(5,3,9,1);
+    assert(stored.range().data() == stored.data());
+
+    // Ranges of temporary sequences keep the elements
+    auto r0 = list(5,3,9,1).range();
+    static_assert(std::is_same<std::iterator_traits<decltype(r0.begin())>::iterator_category, std::forward_iterator_tag>::value, "Forward");
+    int total = 0;
+    for(int x : r0) total += x;
+    assert(total == 18);
+    assert(*std::max_element(r0.begin(), r0.end()) == 9);
+    std::vector<std::string> strings = {"x", "yy"};
+    auto r6 = seq(std::move(strings)).range();
+    assert(std::distance(r6.begin(), r6.end()) == 2 && r6.begin()->size() == 1);
+
+    // Integer ranges give random-access iterators
+    auto r2 = seq(10, 100, 10).range();
+    static_assert(std::is_same<std::iterator_traits<decltype(r2.begin())>::iterator_category, std::random_access_iterator_tag>::value, "Random access");
+    assert(r2.size() == 10);
+    assert(r2.end() - r2.begin() == 10);
+    assert(r2[3] == 40 && r2.begin()[9] == 100);
+    assert(*std::lower_bound(r2.begin(), r2.end(), 55) == 60);
+    assert(std::binary_search(r2.begin(), r2.end(), 70));
+    assert(std::accumulate(r2.begin(), r2.end(), 0) == 550);
+    assert(*(r2.end() - 1) == 100);
+    assert(seq(5,1,-1).range()[4] == 1);
+    assert(seq(1,0).range().empty());
+
+    // Other multipass sequences give forward iterators, whose copies are independent
+    auto r3 = seq(1,10).select([](int x) { return x*x % 7; }).range();
+    static_assert(std::is_same<std::iterator_traits<decltype(r3.begin())>::iterator_category, std::forward_iterator_tag>::value, "Forward");
+    assert(*std::max_element(r3.begin(), r3.end()) == 4);
+    assert(*std::min_element(r3.begin(), r3.end()) == 0);
+    assert(std::distance(r3.begin(), r3.end()) == 10);
+    assert(std::is_sorted(r3.begin(), r3.end()) == false);
+    auto a = r3.begin(), b = a;
+    ++b;
+    ++b;
+    assert(*a == 1 && *b == 2 && a != b);
+    ++a;
+    ++a;
+    assert(a == b);
+    assert(std::adjacent_find(r3.begin(), r3.end()) != r3.end());
+    std::vector<int> copied(r3.begin(), r3.end());
+    assert(seq(copied) == list(1,4,2,2,4,1,0,1,4,2));
+    assert(std::search(r3.begin(), r3.end(), copied.begin()+3, copied.begin()+5) != r3.end());
+
+    auto words = list<std::string>("a","b","c").select([](const std::string & s) { return s + s; }).range();
+    assert(std::find(words.begin(), words.end(), "bb") != words.end());
+    assert(words.begin()->size() == 2);
+
+    auto empty = seq(1,10).where([](int x) { return x > 10; }).range();
+    assert(empty.begin() == empty.end());
+
+    // Single-pass sequences are unchanged, unless they are cached
+    std::istringstream is("abc");
+    auto r4 = seq(is).range();
+    assert(std::string(r4.begin(), r4.end()) == "abc");
+    std::istringstream is2("abcab");
+    auto r5 = seq(is2).cached().range();
+    assert(std::count(r5.begin(), r5.end(), 'a') == 2);
+    assert(*std::max_element(r5.begin(), r5.end()) == 'c');
+}
+
+void test_hash()
+{
+    std::string pattern;
+    for(int i=0; i<1000; ++i) pattern += char(i*7);
+
+    check_hash<sequences::crc32c>("", 0);
+    check_hash<sequences::crc32c>("123456789", 0xE3069283u);
+    check_hash<sequences::xxhash64>("", 0xEF46DB3751D8E999ull);
+    check_hash<sequences::xxhash64>("abc", 0x44BC2CF5AD770999ull);
+    check_hash<sequences::xxhash64>(pattern, 0x25275608A9CFC168ull);
+    check_hash<sequences::fnv1a32>("a", 0xE40C292Cu);
+    check_hash<sequences::fnv1a64>("a", 0xAF63DC4C8601EC8Cull);
+
+    // Slicing-by-8 and hardware CRCs agree on all lengths and alignments
+    for(std::size_t offset=0; offset<8; ++offset)
+        for(std::size_t length : { 0, 1, 7, 8, 9, 100, 991 })
+        {
+            sequences::crc32c crc;
+            crc.update(pattern.data() + offset, length);
+            assert(crc.value() == ~sequences::detail::crc32c_scalar(~0u, reinterpret_cast<const unsigned char*>(pattern.data()) + offset, length));
+        }
+
+    // Pipelines are hashed in the same pass, in blocks where possible
+    assert(seq(0,999).select([](int i) { return char(i*7); }).hash<sequences::xxhash64>() == 0x25275608A9CFC168ull);
+    assert(seq(pattern).take(3).hash(sequences::xxhash64(1)) != seq(pattern).take(3).hash(sequences::xxhash64(2)));
+
+    // Keys can be hashed per element
+    auto hashed = list<std::string>("a", "b", "a").hashed();
+    assert(hashed.at(0).first == hashed.at(2).first);
+    assert(hashed.at(0).first != hashed.at(1).first);
+    assert(hashed.at(1).second == "b");
+    assert(hashed.at(0).first == sequences::key_hash<std::string>()("a"));
+    assert(sequences::key_hash<const char*>()("a") == sequences::key_hash<std::string>()("a"));
+    assert(list(1,2).hashed().keys().at(0) != list(1,2).hashed().keys().at(1));
+}
+
+void test_records()
+{
+    const char * path = "test_records.bin";
+
+    // Trivially copyable elements are stored raw, and read back as a pointer_sequence
+    seq(1,10000).write_to(record_writer<int>(path));
+    {
+        auto ints = read_records<int>(path);
+        const pointer_sequence<int> & view = ints;
+        assert(ints.size() == 10000);
+        assert(view.sum() == 50005000);
+        assert(ints.data()[9999] == 10000);
+        assert((reinterpret_cast<std::uintptr_t>(ints.data()) & 63) == 0);
+        assert(ints.where([](int x) { return x%2==0; }).size() == 5000);
+    }
+
+    typedef std::pair<int, double> point;
+    {
+        auto out = record_writer<point>(path);
+        out << point(1, 2.5) << point(3, 4.5);
+        assert(out.size() == 2);
+    }
+    assert(read_records<point>(path).back() == point(3, 4.5));
+
+    // Other elements are stored as records
+    list<std::string>("a", "", "hello world").write_to(record_writer<std::string>(path));
+    auto strings = read_records<std::string>(path);
+    assert(strings.size() == 3);
+    assert(strings == list<std::string>("a", "", "hello world"));
+    assert(strings.join(",") == "a,,hello world");
+
+    std::vector<std::pair<std::string, int>> pairs;
+    const char * path2 = "test_records2.bin";
+    read_records<std::string>(path).select([](const std::string & s) { return std::make_pair(s, int(s.size())); }).write_to(record_writer<std::pair<std::string, int>>(path2));
+    read_records<std::pair<std::string, int>>(path2).write_to(pairs);
+    std::remove(path2);
+    assert(pairs.size() == 3 && pairs[2].second == 11);
+
+    // Empty files
+    list<int>().write_to(record_writer<int>(path));
+    assert(read_records<int>(path).empty());
+
+    // Errors
+    seq(1,10).write_to(record_writer<int>(path));
+    bool thrown = false;
+    try { read_records<std::int64_t>(path); } catch(std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    thrown = false;
+    try { read_records<std::string>(path); } catch(std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    thrown = false;
+    try { read_records<int>("test_records_missing.bin"); } catch(std::runtime_error&) { thrown = true; }
+    assert(thrown);
+
+    {
+        // A file that was not closed
+        auto out = record_writer<int>(path);
+        out << 1;
+        thrown = false;
+        try { read_records<int>(path); } catch(std::runtime_error&) { thrown = true; }
+        assert(thrown);
+    }
+    assert(read_records<int>(path).size() == 1);
+
+    std::remove(path);
+}
+
+void test_probes()
+{
+    sequences::profiler profiler;
+    {
+        sequences::profiler::scope scope(profiler);
+        assert(&sequences::profiler::current() == &profiler);
+
+        auto pipeline = seq(1,1000).probe("source").
+            where([](int x) { return x%4==0; }).probe("where").
+            select([](int x) { return x*2; }).take(10).probe("take");
+        assert(pipeline.sum() == 440);
+        assert(pipeline.size() == 10);
+    }
+    assert(&sequences::profiler::current() == &sequences::profiler::global());
+
+    auto & source = profiler.stage("source"), & where = profiler.stage("where"), & take = profiler.stage("take");
+    assert(source.elements == 80 && where.elements == 20 && take.elements == 20);
+    assert(source.iterations == 2 && take.iterations == 2);
+    assert(!source.input && where.input == &source && take.input == &where);
+    assert(take.ticks >= where.ticks && where.ticks >= source.ticks);
+
+    auto table = profiler.table();
+    assert(table.find("selectivity") != std::string::npos);
+    assert(table.find("where") != std::string::npos);
+    auto json = profiler.json();
+    assert(json.find("{\"stage\": \"where\", \"in\": 80, \"selectivity\": 0.25, \"out\": 20") != std::string::npos);
+
+    profiler.reset();
+    assert(take.elements == 0 && take.input == &where);
+
+    // Copies of a probe report their own iterations
+    auto probed = list(1,2,3).probe("copy", profiler);
+    auto copy = probed;
+    assert(probed.size() == 3 && copy.size() == 3);
+    assert(profiler.stage("copy").elements == 6);
+
+    // The active probe is restored if the pipeline throws
+    bool thrown = false;
+    try
+    {
+        seq(1,10).select([](int x) { if(x==5) throw std::runtime_error("x"); return x; }).probe("throws", profiler).size();
+    }
+    catch(std::runtime_error &) { thrown = true; }
+    assert(thrown);
+    assert(!sequences::detail::active_probe());
+}
+
+void test_prefetch()
+{
+    // Elements that are pointers are prefetched, and the pipeline is unchanged
+    std::vector<int> values = {5, 3, 8, 1, 9, 2};
+    std::list<const int*> nodes;
+    for(auto & v : values) nodes.push_back(&v);
+    auto deref = [](const int * p) { return *p; };
+    for(std::size_t distance : {0, 1, 2, 6, 100})
+    {
+        auto prefetched = seq(nodes).prefetch(distance).select(deref);
+        assert(prefetched == list(5,3,8,1,9,2));
+        assert(prefetched.size() == 6);
+    }
+    assert(seq<const int*>().prefetch().empty());
+    assert(seq(nodes).prefetch(4).take(2).select(deref) == list(5,3));
+
+    // Elements of containers are read ahead in place, and prefetched themselves
+    assert(seq(values).prefetch(2).where([](int x) { return x > 2; }) == list(5,3,8,9));
+    assert(&seq(values).prefetch(2).front() == &values[0]);
+    std::map<int, std::string> names = {{1, "one"}, {2, "two"}, {3, "three"}};
+    auto named = seq(names).prefetch(2);
+    assert(&named.skip(2).front() == &*names.rbegin());
+    assert(named.select([](const std::pair<const int, std::string> & kv) { return kv.second.size(); }) == list(3,3,5));
+
+    // Other elements are buffered without prefetching, unless given an address
+    assert(seq(1,5).select([](int x) { return x*2; }).prefetch(2) == list(2,4,6,8,10));
+    std::map<int, const int*> index = {{1, &values[1]}, {2, &values[0]}, {3, &values[5]}};
+    auto by_key = seq(index).prefetch(2, [](const std::pair<const int, const int*> & kv) { return kv.second; });
+    assert(by_key.select([](const std::pair<const int, const int*> & kv) { return *kv.second; }) == list(3,5,2));
+
+    // Virtual iteration and forward ranges
+    const sequence<int> & v = seq(1,10).prefetch(3);
+    assert(v.sum() == 55);
+    auto r = seq(1,10).select([](int x) { return x%4; }).prefetch(2).range();
+    assert(*std::max_element(r.begin(), r.end()) == 3);
+
+    // gather() reads base[i] for each index
+    const char * text = "abcdefgh";
+    assert(gather(list(7,0,3,3), text).join() == "hadd");
+    assert(gather(seq(0,7).where([](int i) { return i%2; }), text, 2).join() == "bdfh");
+    assert(gather(seq<int>(), text).empty());
+    assert(gather(seq(0,5), values.data(), 1) == seq(values));
+    auto g = gather(list(1,2), values.data());
+    assert(&g.front() == &values[1]);
+}
+
 void test_aggregate()
 {
     auto sum = [](int a, int b) { return a+b; };
@@ -420,11 +1432,321 @@ void test_accumulate()
     assert(list(3,4,5).accumulate(std::string(), [](std::string & str, int n) { str+='x'; })=="xxx");
 }
 
+void test_reverse()
+{
+    std::vector<int> vec = {1,2,3,4};
+    std::list<int> lst = {1,2,3,4};
+    std::map<int, char> map1 = { {1,'a'}, {2,'b'} };
+
+    assert(list(1,2,3).reverse() == list(3,2,1));
+    assert(list<int>().reverse() == list<int>());
+    assert(single(1).reverse() == list(1));
+    assert(seq(vec).reverse() == list(4,3,2,1));
+    assert(seq(lst).reverse() == list(4,3,2,1));
+    assert(seq(map1).keys().reverse() == list(2,1));
+    assert(seq(1,5).reverse() == list(5,4,3,2,1));
+    assert(seq(1,5).reverse().reverse() == seq(1,5));
+    assert(seq("abc").reverse() == seq("cba"));
+
+    // Pipelines are reversed without buffering
+    auto evens = seq(1,10).where([](int x) { return x%2==0; });
+    assert(evens.reverse() == list(10,8,6,4,2));
+    assert(evens.select([](int x) { return x*10; }).reverse() == list(100,80,60,40,20));
+    assert(seq(1,10).take(3).reverse() == list(3,2,1));
+    assert(seq(1,3).take(5).reverse() == list(3,2,1));
+    assert(seq(1,3).take(0).reverse() == list<int>());
+    assert(seq(1,10).skip(7).reverse() == list(10,9,8));
+    assert(seq(1,3).skip(5).reverse() == list<int>());
+    assert(list(1,2,3).take(-1).reverse() == list<int>());
+    assert(list(1,2,3).skip(-1).reverse() == list(3,2,1));
+
+    // Sizes beyond the range of int are not truncated
+    auto id = [](long long x) { return x; };
+    assert(seq<long long>(0, 1LL<<31).select(id).take(INT_MAX).reverse().first());
+    assert(*seq<long long>(0, 1LL<<31).select(id).take(INT_MAX).reverse().first() == INT_MAX-1);
+    assert(seq<long long>(0, (1LL<<32)+1).select(id).skip(2).reverse().take(2) == list((1LL<<32)+1, 1LL<<32));
+    assert((list(1,2) + list(3,4)).reverse() == list(4,3,2,1));
+    assert(list(1,2).repeat(2).reverse() == list(2,1,2,1));
+
+    // Forward-only sequences are buffered
+    std::stringstream ss("hello");
+    assert(seq(ss).reverse() == seq("olleh"));
+    auto less3 = seq(1,10).take_while([](int x) { return x<3; });
+    assert(less3.reverse() == list(2,1));
+    assert(seq(1,1000).take_while([](int x) { return x<1000; }).reverse().size() == 999);
+    assert(seq(1,1000).take_while([](int x) { return x<1000; }).reverse().front() == 999);
+    assert(seq(1,1000).take_while([](int x) { return x<1000; }).reverse().back() == 1);
+    assert(seq(1,1000).take_while([](int x) { return x<1000; }).reverse().reverse() == seq(1,999));
+
+    const sequence<int> & s = list(1,2,3);
+    assert(s.reverse() == list(3,2,1));
+
+    // back() uses reverse iteration where available
+    assert(seq(vec).back() == 4);
+    assert(evens.back() == 10);
+    assert(seq(1,10).take(4).back() == 4);
+    assert(list<int>().back_or_default(5) == 5);
+    assert(seq(lst).back_or_default(5) == 4);
+}
+
+void test_cached()
+{
+    int calls = 0;
+    auto evens = seq(1,100).where([&](int x) { ++calls; return x%2==0; }).cached();
+
+    // Nothing is evaluated until the sequence is iterated
+    assert(calls == 0);
+
+    // A partial evaluation only evaluates what it needs
+    assert(evens.take(2) == list(2,4));
+    assert(calls == 4);
+
+    // Subsequent iterations resume where the cache stopped
+    assert(evens.size() == 50);
+    assert(calls == 100);
+    assert(evens.sum() == 2550);
+    assert(evens.at(3) == 8);
+    assert(evens.back() == 100);
+    assert(evens.any());
+    assert(calls == 100);
+
+    // Streams can be iterated more than once
+    std::stringstream ss("a,b,c");
+    auto tokens = seq(ss).split(",").cached();
+    assert(tokens == list("a","b","c"));
+    assert(tokens == list("a","b","c"));
+    assert(tokens.size() == 3);
+
+    // Lots of elements spanning multiple chunks
+    auto squares = seq(0,99999).select([](int x) { return (long long)x*x; }).cached();
+    assert(squares.size() == 100000);
+    assert(squares.at(99999) == 99999LL*99999);
+    assert(squares == seq(0,99999).select([](int x) { return (long long)x*x; }));
+
+    // Concurrent readers share the cache
+    auto values = seq(1,100000).select([](int x) { return (long long)x; }).cached();
+    auto f1 = std::async(std::launch::async, [=]() { return values.sum(); });
+    auto f2 = std::async(std::launch::async, [=]() { return values.sum(); });
+    assert(f1.get() == 5000050000LL);
+    assert(f2.get() == 5000050000LL);
+
+    assert(list<int>().cached().empty());
+}
+
+void test_spill()
+{
+    // Trivially copyable elements, mostly on disk
+    auto squares = seq(0,99999).select([](int x) { return (long long)x*x; }).spill(nullptr, 1000);
+    assert(squares.size() == 100000);
+    assert(squares.sum() == seq(0,99999).select([](int x) { return (long long)x*x; }).sum());
+    assert(squares == seq(0,99999).select([](int x) { return (long long)x*x; }));
+    assert(squares.at(50000) == 50000LL*50000);
+
+    // Partial iteration resumes from the underlying sequence
+    int calls = 0;
+    auto values = seq(1,1000).select([&](int x) { ++calls; return x; }).spill(nullptr, 100);
+    assert(values.take(200) == seq(1,200));
+    assert(calls == 200);
+    assert(values == seq(1,1000));
+    assert(values == seq(1,1000));
+    assert(calls == 1000);
+
+    // Strings are stored as records
+    std::stringstream ss;
+    for(int i=0; i<1000; ++i) ss << "token" << i << ",";
+    auto tokens = seq(ss).split(",").spill("test_spill.bin", 256);
+    assert(tokens.size() == 1000);
+    assert(tokens.front() == "token0");
+    assert(tokens.back() == "token999");
+    assert(tokens.skip(500).front() == "token500");
+    assert(tokens.where([](const std::string & s) { return s.size()==6; }).size() == 10);
+
+    // Existing files are not overwritten
+    {
+        std::ofstream("test_spill_existing.bin") << "keep";
+        auto existing = seq(1,100).spill("test_spill_existing.bin", 40);
+        bool thrown = false;
+        try { existing.size(); } catch(std::runtime_error&) { thrown = true; }
+        assert(thrown);
+    }
+    assert(read_file("test_spill_existing.bin") == "keep");
+    std::remove("test_spill_existing.bin");
+
+    // Directories get a new temporary file
+    auto in_directory = seq(1,1000).spill(".", 40);
+    assert(in_directory == seq(1,1000));
+    assert(in_directory.sum() == 500500);
+
+    // A copy extends the storage onto disk while another copy is being iterated
+    auto numbers = seq(1,100).spill(nullptr, 40);
+    auto numbers2 = numbers;
+    assert(numbers.front() == 1);
+    assert(numbers2 == seq(1,100));
+    assert(numbers == seq(1,100));
+
+    // Everything fits in memory
+    auto small = list(1,2,3).spill();
+    assert(small == list(1,2,3));
+    assert(small.size() == 3);
+    assert(list<int>().spill().empty());
+}
+
+void test_arena()
+{
+    sequences::arena arena;
+    {
+        sequences::arena_scope scope(arena);
+
+        // Internal buffers are allocated from the arena
+        auto evens = seq(1,1000).where([](int x) { return x%2==0; }).cached();
+        assert(evens.size() == 500);
+        assert(arena.bytes_allocated() > 500*sizeof(int));
+
+        std::stringstream ss("a,bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb,c");
+        assert(seq(ss).reverse() == seq(ss.str().c_str()).reverse());
+
+        // Containers can be filled using arena_allocator
+        std::vector<int, sequences::arena_allocator<int>> vec;
+        writer(vec) << seq(1,100);
+        assert(seq(vec) == seq(1,100));
+
+        auto set = seq(1,10).make<std::set<int, std::less<int>, sequences::arena_allocator<int>>>(sequences::arena_allocator<int>());
+        assert(seq(set) == seq(1,10));
+    }
+
+    std::size_t used = arena.bytes_allocated();
+    assert(arena.bytes_allocated() > 0);
+
+    // Tokens can be allocated in an arena
+    auto tokens = seq("hello,this is a long string that will not fit in a small string,world").split(",", sequences::arena_allocator<char>(arena));
+    assert(tokens == list("hello","this is a long string that will not fit in a small string","world"));
+    assert(arena.bytes_allocated() > used);
+
+    // An arena can use a buffer on the stack
+    char buffer[1024];
+    sequences::arena small(buffer, sizeof(buffer));
+    void * p = small.allocate(100);
+    assert(p >= (void*)buffer && p < (void*)(buffer+sizeof(buffer)));
+    small.allocate(2000);
+    assert(small.bytes_allocated() == 2100);
+
+    arena.release();
+    assert(arena.bytes_allocated() == 0);
+}
+
+struct Order
+{
+    int id;
+    std::vector<int> items;
+};
+
+void test_select_many()
+{
+    // Flatten lines into words
+    auto words = seq("the cat\nsat on\n\nthe mat").split("\n").select_many([](const std::string & line) {
+        return seq(line).split(" ");
+    });
+    assert(words == list("the","cat","sat","on","the","mat"));
+    assert(words.size() == 6);
+
+    // Flatten containers
+    std::vector<Order> orders = { {1, {10,11}}, {2, {}}, {3, {30}} };
+    auto items = seq(orders).select_many([](const Order & o) { return seq(o.items); });
+    assert(items == list(10,11,30));
+    assert(items.sum() == 51);
+
+    // Inner sequences can be pipelines
+    auto pairs = seq(1,3).select_many([](int n) { return seq(1,n).select([=](int m) { return n*10+m; }); });
+    assert(pairs == list(11,21,22,31,32,33));
+
+    // Empty sequences
+    assert(list<int>().select_many([](int n) { return seq(1,n); }).empty());
+    assert(list(0,0).select_many([](int n) { return seq(1,n); }).empty());
+
+    // The functor can write to an output sequence
+    auto repeated = list(1,2,3).select_many([](int n, const output_sequence<int> & out) {
+        for(int i=0; i<n; ++i) out << n;
+    });
+    assert(repeated == list(1,2,2,3,3,3));
+    assert(repeated == list(1,2,2,3,3,3));
+
+    auto many = seq(1,3).select_many([](int n, const output_sequence<int> & out) {
+        out << seq(1, n*1000);
+    });
+    assert(many.size() == 6000);
+    assert(many.sum() == 500500 + 2001000 + 4501500);
+
+    // Blocks are the contiguous runs of the inner sequences
+    std::vector<std::vector<int>> rows = { {1,2,3}, {}, {4}, std::vector<int>(100, 1) };
+    auto cells = seq(rows).select_many([](const std::vector<int> & row) { return seq(row.data(), row.data()+row.size()); });
+    static_assert(sequences::helpers::is_blockwise<decltype(cells)>::value, "select_many() of contiguous sequences is blockwise");
+    assert(cells.size() == 104);
+    assert(cells.sum() == 110);
+    assert(cells.where([](int n) { return n>1; }).size() == 3);
+    int buffer[sequences::helpers::block_size];
+    std::size_t n = sequences::helpers::block_size;
+    auto block = cells.first_block(buffer, n);
+    assert(n == 3 && block == rows[0].data());
+    block = cells.next_block(buffer, n = sequences::helpers::block_size);
+    assert(n == 1 && block == rows[2].data());
+    block = cells.next_block(buffer, n = sequences::helpers::block_size);
+    assert(n == 64 && block == rows[3].data());
+    block = cells.next_block(buffer, n = sequences::helpers::block_size);
+    assert(n == 36 && block == rows[3].data() + 64);
+    cells.next_block(buffer, n = sequences::helpers::block_size);
+    assert(n == 0);
+
+    // Inner sequences that are blockwise
+    auto ranges = seq(1,3).select_many([](int n) { return seq(1, n*100); });
+    static_assert(sequences::helpers::is_blockwise<decltype(ranges)>::value, "select_many() of blockwise sequences is blockwise");
+    assert(ranges.size() == 600);
+    assert(ranges.sum() == 5050 + 20100 + 45150);
+    assert(ranges.where([](int n) { return n%100 == 0; }).size() == 6);
+}
+
+void test_join()
+{
+    assert(list<std::string>().join() == "");
+    assert(list<std::string>().join(", ") == "");
+    assert(list<std::string>("a").join(", ") == "a");
+    assert(list<std::string>("a", "bc", "def").join() == "abcdef");
+    assert(list<std::string>("a", "bc", "def").join(", ") == "a, bc, def");
+
+    // C strings
+    assert(list("x", "y", "z").join("-") == "x-y-z");
+
+    // Characters
+    assert(seq("hello").join() == "hello");
+    assert(seq("abc").join(" ") == "a b c");
+    assert(list('a').repeat(1000).join().size() == 1000);
+    assert(list(L'a', L'b').join() == L"ab");
+    static_assert(std::is_same<decltype(list(u'a').join()), std::u16string>::value, "char16_t joins to u16string");
+
+    // Wide strings
+    assert(list<std::wstring>(L"a", L"b").join(L"+") == L"a+b");
+
+    // Single-pass sequences
+    std::stringstream ss("the quick brown fox");
+    assert(seq(ss).split(" ").join("_") == "the_quick_brown_fox");
+    assert(seq(1,5).select([](int x) { return std::to_string(x); }).join(",") == "1,2,3,4,5");
+
+    // Virtual sequences
+    const sequence<const char*> & s = list("a", "b");
+    assert(s.join("/") == "a/b");
+}
+
 int main()
 {
     test_lifetimes();
     test_writers();
+    test_bulk_output();
+    test_concurrent_output();
+#if SEQUENCE_ENABLE_POSIX
+    test_file_writer();
+    test_file_reader();
+#endif
     test_range();
+    test_range_closed_form();
     test_comparisons();
     test_single();
     test_list();
@@ -438,10 +1760,28 @@ int main()
     test_take_while();
     test_skip_until();
     test_merge();
+    test_zip();
+    test_merge_sorted();
+    test_set_operations();
+    test_windows();
+    test_chunk();
+    test_blocks();
     test_sum();
     test_any();
     test_count();
+    test_search();
+    test_ranges();
+    test_hash();
+    test_records();
+    test_probes();
+    test_prefetch();
     test_aggregate();
     test_accumulate();
+    test_reverse();
+    test_cached();
+    test_spill();
+    test_arena();
+    test_select_many();
+    test_join();
     return 0;
 }
\ No newline at end of file